@@ -1,77 +1,392 @@
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <new>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // задача 1
+// коды ошибок для try_-функций: на грязных данных ошибка -- обычный исход,
+// и платить за него раскруткой стека и аллокацией незачем
+enum class ErrorCode : unsigned char {
+  ok,
+  math,
+  overflow,
+  underflow,
+  bad_from_string,
+};
+
+// сообщения статические: исключения, построенные по коду, ничего не выделяют
+constexpr const char* error_message(ErrorCode code) {
+  switch (code) {
+    case ErrorCode::ok:
+      return "ok";
+    case ErrorCode::math:
+      return "math error";
+    case ErrorCode::overflow:
+      return "overflow error";
+    case ErrorCode::underflow:
+      return "underflow error";
+    case ErrorCode::bad_from_string:
+      return "bad_from_string error";
+  }
+  return "unknown error";
+}
+
+// значение или код ошибки, как std::expected<T, ErrorCode> из C++23
+template <typename T>
+class Result {
+ private:
+  T value_;
+  ErrorCode error_;
+
+ public:
+  constexpr Result(T value) noexcept(
+      std::is_nothrow_move_constructible_v<T>)
+      : value_(std::move(value)), error_(ErrorCode::ok) {}
+  constexpr Result(ErrorCode error) noexcept(
+      std::is_nothrow_default_constructible_v<T>)
+      : value_(), error_(error) {}
+
+  constexpr bool has_value() const noexcept { return error_ == ErrorCode::ok; }
+  constexpr explicit operator bool() const noexcept { return has_value(); }
+
+  // только при has_value()
+  constexpr T& operator*() noexcept { return value_; }
+  constexpr const T& operator*() const noexcept { return value_; }
+  constexpr const T* operator->() const noexcept { return &value_; }
+
+  constexpr T value_or(T fallback) const {
+    return has_value() ? value_ : std::move(fallback);
+  }
+
+  constexpr ErrorCode error() const noexcept { return error_; }
+};
+
+// сообщения из error_message статические и хранятся указателем, любые
+// другие строки копируются; message == nullptr значит, что текст в owned
 class MathException : public std::exception {
  private:
-  std::string message;
+  const char* message;
+  std::string owned;
+
+ protected:
+  explicit MathException(ErrorCode code) : message(error_message(code)) {}
 
  public:
-  MathException() : message("math error") {}
-  MathException(const std::string& msg) : message(msg) {}
+  MathException() : MathException(ErrorCode::math) {}
+  explicit MathException(const char* msg) : message(nullptr), owned(msg) {}
+  MathException(const std::string& msg) : message(nullptr), owned(msg) {}
 
-  const char* what() const noexcept override { return message.c_str(); }
+  const char* what() const noexcept override {
+    return message ? message : owned.c_str();
+  }
 };
 
 class OverflowError : public MathException {
  public:
-  OverflowError() : MathException("overflow error") {}
+  OverflowError() : MathException(ErrorCode::overflow) {}
 };
 
 class UnderflowError : public MathException {
  public:
-  UnderflowError() : MathException("underflow error") {}
+  UnderflowError() : MathException(ErrorCode::underflow) {}
 };
 
-int divide(int x, int y) {
-  if (y == 0) throw OverflowError();
+// INT_MIN / -1 не помещается в int -- тоже переполнение
+constexpr Result<int> try_divide(int x, int y) noexcept {
+  if (y == 0) return ErrorCode::overflow;
+  if (y == -1 && x == std::numeric_limits<int>::min()) {
+    return ErrorCode::overflow;
+  }
   return x / y;
 }
 
+int divide(int x, int y) {
+  Result<int> result = try_divide(x, y);
+  if (!result) throw OverflowError();
+  return *result;
+}
+
 // задача 2
-template <typename T>
-struct ControlBlock {
+// политики счётчика ссылок: AtomicCount можно копировать между потоками,
+// LocalCount -- только внутри одного потока, зато без атомарных операций
+struct AtomicCount {
+  static constexpr bool thread_safe = true;
+
+  std::atomic<size_t> value;
+
+  explicit AtomicCount(size_t initial) : value(initial) {}
+
+  // новая ссылка появляется из уже существующей, порядок не нужен
+  void increment() { value.fetch_add(1, std::memory_order_relaxed); }
+
+  // true, если ссылок не осталось; release/acquire, чтобы все записи в
+  // объект из других потоков были видны тому, кто его удаляет
+  bool decrement() {
+    if (value.fetch_sub(1, std::memory_order_release) == 1) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+  }
+
+  // для weak_ptr::lock: оживлять уже умерший объект нельзя
+  bool increment_if_nonzero() {
+    size_t count = value.load(std::memory_order_relaxed);
+    while (count != 0) {
+      if (value.compare_exchange_weak(count, count + 1,
+                                      std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  size_t load() const { return value.load(std::memory_order_relaxed); }
+};
+
+struct LocalCount {
+  static constexpr bool thread_safe = false;
+
+  size_t value;
+
+  explicit LocalCount(size_t initial) : value(initial) {}
+
+  void increment() { ++value; }
+  bool decrement() { return --value == 0; }
+  bool increment_if_nonzero() { return value != 0 && ++value; }
+  size_t load() const { return value; }
+};
+
+// пул блоков одного размерного класса: освобождённые блоки остаются в
+// списке своего потока и переиспользуются без обращения к malloc
+template <size_t Size>
+class BlockPool {
+  struct Node {
+    Node* next;
+  };
+
+  static_assert(Size >= sizeof(Node), "block is too small for the free list");
+
+  struct FreeList {
+    Node* head = nullptr;
+    size_t count = 0;
+
+    ~FreeList() {
+      while (head) ::operator delete(std::exchange(head, head->next));
+      list_destroyed() = true;
+    }
+  };
+
+  static FreeList& free_list() {
+    thread_local FreeList list;
+    return list;
+  }
+
+  // после разрушения списка (shared_ptr в других thread_local) блоки идут
+  // мимо него прямо в operator delete. Флаг тривиально разрушаемый, его
+  // можно читать и после ~FreeList
+  static bool& list_destroyed() {
+    thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+ public:
+  static constexpr size_t max_cached = 1024;
+
+  static void* allocate() {
+    if (list_destroyed()) return ::operator new(Size);
+    FreeList& list = free_list();
+    if (!list.head) return ::operator new(Size);
+    --list.count;
+    return std::exchange(list.head, list.head->next);
+  }
+
+  static void deallocate(void* p) {
+    if (list_destroyed()) {
+      ::operator delete(p);
+      return;
+    }
+    FreeList& list = free_list();
+    if (list.count >= max_cached) {
+      ::operator delete(p);
+      return;
+    }
+    ++list.count;
+    list.head = new (p) Node{list.head};
+  }
+};
+
+// weak_count -- число weak_ptr плюс одна ссылка на всех shared_ptr сразу:
+// блок живёт, пока есть хоть кто-то, объект -- пока есть shared_ptr
+template <typename RefCount>
+struct ControlBlockBase {
+  RefCount ref_count;
+  RefCount weak_count;
+
+  ControlBlockBase() : ref_count(1), weak_count(1) {}
+
+  // разрушает объект, когда не осталось ссылок
+  virtual void dispose() = 0;
+  // освобождает сам блок
+  virtual void destroy() = 0;
+
+ protected:
+  ~ControlBlockBase() = default;
+};
+
+// блок для указателя, созданного снаружи через new; сами блоки берутся из
+// BlockPool, так как у всех T они одного размера
+template <typename T, typename RefCount = AtomicCount>
+struct ControlBlock final : ControlBlockBase<RefCount> {
+  static constexpr size_t pool_size =
+      (sizeof(ControlBlockBase<RefCount>) + sizeof(T*) + 15) / 16 * 16;
+
   T* object;
-  size_t ref_count;
 
-  ControlBlock(T* obj) : object(obj), ref_count(1) {}
+  ControlBlock(T* obj) : object(obj) {}
+
+  void dispose() override { delete object; }
+  void destroy() override { delete this; }
+
+  static void* operator new(size_t) {
+    static_assert(sizeof(ControlBlock) <= pool_size);
+    return BlockPool<pool_size>::allocate();
+  }
+
+  static void operator delete(void* p) { BlockPool<pool_size>::deallocate(p); }
+};
+
+// блок для make_shared: счётчик и объект в одной аллокации, рядом в памяти
+template <typename T, typename RefCount = AtomicCount>
+struct InplaceControlBlock final : ControlBlockBase<RefCount> {
+  alignas(T) unsigned char storage[sizeof(T)];
+
+  template <typename... Args>
+  explicit InplaceControlBlock(Args&&... args) {
+    new (storage) T(std::forward<Args>(args)...);
+  }
+
+  T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
 
-  ~ControlBlock() { delete object; }
+  void dispose() override { object()->~T(); }
+  void destroy() override { delete this; }
 };
 
+template <typename T, typename RefCount>
+class weak_ptr;
+
+template <typename T, typename RefCount>
+class atomic_shared_ptr;
+
 // скопировано наполовину из smart_pointers.md
-template <typename T>
+template <typename T, typename RefCount = AtomicCount>
 class shared_ptr {
  private:
   T* ptr;
-  ControlBlock<T>* control;
+  ControlBlockBase<RefCount>* control;
+
+  shared_ptr(T* p, ControlBlockBase<RefCount>* c) : ptr(p), control(c) {}
+
+  // если блок не выделился, объект удаляется, как в std::shared_ptr
+  static ControlBlockBase<RefCount>* adopt(T* p) {
+    if (!p) return nullptr;
+    try {
+      return new ControlBlock<T, RefCount>(p);
+    } catch (...) {
+      delete p;
+      throw;
+    }
+  }
 
  public:
+  using count_type = RefCount;
+
   shared_ptr() : ptr(nullptr), control(nullptr) {}
 
-  explicit shared_ptr(T* p)
-      : ptr(p), control(p ? new ControlBlock<T>(p) : nullptr) {}
+  explicit shared_ptr(T* p) : ptr(p), control(adopt(p)) {}
 
   shared_ptr(const shared_ptr& other) : ptr(other.ptr), control(other.control) {
     if (control) {
-      ++control->ref_count;
+      control->ref_count.increment();
+    }
+  }
+
+  // перемещение забирает ссылку у other, счётчик не трогается
+  shared_ptr(shared_ptr&& other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)),
+        control(std::exchange(other.control, nullptr)) {}
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  shared_ptr(const shared_ptr<U, RefCount>& other)
+      : ptr(other.ptr), control(other.control) {
+    if (control) {
+      control->ref_count.increment();
     }
   }
 
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  shared_ptr(shared_ptr<U, RefCount>&& other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)),
+        control(std::exchange(other.control, nullptr)) {}
+
+  // aliasing: владеет тем же, что owner, а указывает на p (обычно его поле)
+  template <typename U>
+  shared_ptr(const shared_ptr<U, RefCount>& owner, T* p)
+      : ptr(p), control(owner.control) {
+    if (control) {
+      control->ref_count.increment();
+    }
+  }
+
+  template <typename U>
+  shared_ptr(shared_ptr<U, RefCount>&& owner, T* p) noexcept
+      : ptr(p), control(std::exchange(owner.control, nullptr)) {
+    owner.ptr = nullptr;
+  }
+
   shared_ptr& operator=(const shared_ptr& other) {
     if (this != &other) {
       release();
       ptr = other.ptr;
       control = other.control;
       if (control) {
-        ++control->ref_count;
+        control->ref_count.increment();
       }
     }
     return *this;
   }
 
+  shared_ptr& operator=(shared_ptr&& other) noexcept {
+    if (this != &other) {
+      release();
+      ptr = std::exchange(other.ptr, nullptr);
+      control = std::exchange(other.control, nullptr);
+    }
+    return *this;
+  }
+
+  void swap(shared_ptr& other) noexcept {
+    std::swap(ptr, other.ptr);
+    std::swap(control, other.control);
+  }
+
   ~shared_ptr() { release(); }
 
   T& operator*() const { return *ptr; }
@@ -80,7 +395,7 @@ class shared_ptr {
 
   T* get() const { return ptr; }
 
-  size_t use_count() const { return control ? control->ref_count : 0; }
+  size_t use_count() const { return control ? control->ref_count.load() : 0; }
 
   bool unique() const { return use_count() == 1; }
 
@@ -93,58 +408,571 @@ class shared_ptr {
   }
 
   void reset(T* p) {
+    auto* fresh = adopt(p);
     release();
     ptr = p;
-    control = p ? new ControlBlock<T>(p) : nullptr;
+    control = fresh;
   }
 
  private:
   void release() {
-    if (control) {
-      --control->ref_count;
-      if (control->ref_count == 0) {
-        delete control;
+    if (control && control->ref_count.decrement()) {
+      control->dispose();
+      if (control->weak_count.decrement()) {
+        control->destroy();
       }
     }
   }
 
+  template <typename U, typename R>
+  friend class shared_ptr;
+
+  template <typename U, typename R>
+  friend class weak_ptr;
+  friend class atomic_shared_ptr<T, RefCount>;
+
   template <typename U>
   friend shared_ptr<U> make_shared();
 
   template <typename U, typename... Args>
   friend shared_ptr<U> make_shared(Args&&... args);
+
+  template <typename U, typename... Args>
+  friend shared_ptr<U, LocalCount> make_local_shared(Args&&... args);
+};
+
+// не держит объект, только блок: кэши и обратные ссылки не мешают
+// освободить память, как только уйдёт последний shared_ptr
+template <typename T, typename RefCount = AtomicCount>
+class weak_ptr {
+ private:
+  T* ptr;
+  ControlBlockBase<RefCount>* control;
+
+ public:
+  weak_ptr() : ptr(nullptr), control(nullptr) {}
+
+  weak_ptr(const shared_ptr<T, RefCount>& shared)
+      : ptr(shared.ptr), control(shared.control) {
+    if (control) {
+      control->weak_count.increment();
+    }
+  }
+
+  // объект жив, пока есть shared, так что приводить указатель безопасно
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  weak_ptr(const shared_ptr<U, RefCount>& shared)
+      : ptr(shared.ptr), control(shared.control) {
+    if (control) {
+      control->weak_count.increment();
+    }
+  }
+
+  weak_ptr(const weak_ptr& other) : ptr(other.ptr), control(other.control) {
+    if (control) {
+      control->weak_count.increment();
+    }
+  }
+
+  weak_ptr(weak_ptr&& other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)),
+        control(std::exchange(other.control, nullptr)) {}
+
+  weak_ptr& operator=(const weak_ptr& other) {
+    if (this != &other) {
+      release();
+      ptr = other.ptr;
+      control = other.control;
+      if (control) {
+        control->weak_count.increment();
+      }
+    }
+    return *this;
+  }
+
+  weak_ptr& operator=(weak_ptr&& other) noexcept {
+    if (this != &other) {
+      release();
+      ptr = std::exchange(other.ptr, nullptr);
+      control = std::exchange(other.control, nullptr);
+    }
+    return *this;
+  }
+
+  ~weak_ptr() { release(); }
+
+  size_t use_count() const { return control ? control->ref_count.load() : 0; }
+
+  bool expired() const { return use_count() == 0; }
+
+  // пустой shared_ptr, если объект уже разрушен
+  shared_ptr<T, RefCount> lock() const {
+    if (control && control->ref_count.increment_if_nonzero()) {
+      return shared_ptr<T, RefCount>(ptr, control);
+    }
+    return shared_ptr<T, RefCount>();
+  }
+
+  void reset() {
+    release();
+    ptr = nullptr;
+    control = nullptr;
+  }
+
+ private:
+  void release() {
+    if (control && control->weak_count.decrement()) {
+      control->destroy();
+    }
+  }
+};
+
+// указатель, который нельзя отдавать другим потокам; смешать его с
+// shared_ptr<T> не даст компилятор -- это разные типы
+template <typename T>
+using local_shared_ptr = shared_ptr<T, LocalCount>;
+
+// для API, принимающих указатели из разных потоков:
+// static_assert(is_thread_safe_v<Ptr>)
+template <typename Ptr>
+constexpr bool is_thread_safe_v = Ptr::count_type::thread_safe;
+
+// слот для публикации данных многим читателям без мьютекса.
+// Split reference count: в старших 16 битах слова -- внешний счётчик
+// закреплений, в младших 48 -- адрес узла. Читатель закрепляет узел одним
+// fetch_add по слову, а снимает закрепление уже во внутреннем счётчике
+// узла, так что на слове одна RMW-операция на load. Писатель подменяет
+// слово целиком и переносит внешний счётчик во внутренний; когда внешний
+// дорастает до flush_pins, читатель сам переносит его, не дожидаясь
+// писателя. Поэтому одновременных читателей должно быть меньше 2^15.
+// Адрес узла проверяется при создании: с LA57 или тегами в старших битах
+// (TBI, MTE) он может не влезть в 48 бит -- тогда std::bad_alloc
+template <typename T, typename RefCount = AtomicCount>
+class atomic_shared_ptr {
+  static_assert(RefCount::thread_safe,
+                "atomic_shared_ptr needs a thread-safe reference count");
+  static_assert(sizeof(void*) == 8, "pointer must fit into 48 bits");
+
+  // пока узел в слоте, внутренний счётчик держит slot_pins сверх
+  // перенесённых закреплений: снятия, обогнавшие перенос, не доведут его
+  // до нуля
+  static constexpr std::int64_t slot_pins = std::int64_t(1) << 32;
+
+  struct Node {
+    shared_ptr<T, RefCount> value;
+    // перенесённые закрепления минус снятые, плюс slot_pins, пока узел
+    // в слоте
+    std::atomic<std::int64_t> pins{slot_pins};
+  };
+
+  static constexpr std::uint64_t one_pin = std::uint64_t(1) << 48;
+  static constexpr std::uint64_t address_mask = one_pin - 1;
+  static constexpr std::uint64_t flush_pins = std::uint64_t(1) << 15;
+
+  mutable std::atomic<std::uint64_t> word;
+
+  static Node* node_of(std::uint64_t w) {
+    return reinterpret_cast<Node*>(w & address_mask);
+  }
+
+  static std::uint64_t pack(Node* node) {
+    return reinterpret_cast<std::uintptr_t>(node);
+  }
+
+  // при ошибке value остаётся у вызывающего
+  static Node* make_node(shared_ptr<T, RefCount>&& value) {
+    if (!value) return nullptr;
+    Node* node = new Node{std::move(value)};
+    if (pack(node) & ~address_mask) {
+      value = std::move(node->value);
+      delete node;
+      throw std::bad_alloc();
+    }
+    return node;
+  }
+
+  static bool same(Node* node, const shared_ptr<T, RefCount>& p) {
+    if (!node) return !p.control && !p.ptr;
+    return node->value.ptr == p.ptr && node->value.control == p.control;
+  }
+
+  // возвращает слово после закрепления. У пустого слота счётчик тоже
+  // растёт, но его никто не читает и переполнение не задевает адрес
+  std::uint64_t pin() const {
+    std::uint64_t const current =
+        word.fetch_add(one_pin, std::memory_order_acquire) + one_pin;
+    Node* node = node_of(current);
+    if (node && (current >> 48) >= flush_pins) flush(node);
+    return current;
+  }
+
+  // переносит внешний счётчик во внутренний. Сначала прибавляем, потом
+  // вычитаем из слова: лишнее закрепление безопасно, недостающее -- нет.
+  // Вызывающий держит свой pin, так что узел не удалится
+  void flush(Node* node) const {
+    std::uint64_t current = word.load(std::memory_order_relaxed);
+    while (node_of(current) == node && (current >> 48) >= flush_pins) {
+      std::uint64_t const moved = current >> 48;
+      node->pins.fetch_add(static_cast<std::int64_t>(moved),
+                           std::memory_order_acq_rel);
+      if (word.compare_exchange_weak(current, current - moved * one_pin,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_relaxed)) {
+        return;
+      }
+      node->pins.fetch_sub(static_cast<std::int64_t>(moved),
+                           std::memory_order_acq_rel);
+    }
+  }
+
+  static void unpin(Node* node) {
+    if (node->pins.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete node;
+    }
+  }
+
+  // вызывается тем, кто снял узел из слова; pins -- внешний счётчик в
+  // снятом слове за вычетом своих закреплений
+  static void retire(Node* node, std::int64_t pins) {
+    std::int64_t const delta = pins - slot_pins;
+    if (node &&
+        node->pins.fetch_add(delta, std::memory_order_acq_rel) + delta == 0) {
+      delete node;
+    }
+  }
+
+ public:
+  static constexpr bool is_always_lock_free =
+      std::atomic<std::uint64_t>::is_always_lock_free;
+
+  atomic_shared_ptr() : word(0) {}
+
+  atomic_shared_ptr(shared_ptr<T, RefCount> value)
+      : word(pack(make_node(std::move(value)))) {}
+
+  atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+  atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+  ~atomic_shared_ptr() {
+    std::uint64_t const last = word.load();
+    retire(node_of(last), static_cast<std::int64_t>(last >> 48));
+  }
+
+  shared_ptr<T, RefCount> load() const {
+    Node* node = node_of(pin());
+    if (!node) return shared_ptr<T, RefCount>();
+    shared_ptr<T, RefCount> result = node->value;
+    unpin(node);
+    return result;
+  }
+
+  void store(shared_ptr<T, RefCount> value) { exchange(std::move(value)); }
+
+  shared_ptr<T, RefCount> exchange(shared_ptr<T, RefCount> value) {
+    std::uint64_t old = word.exchange(pack(make_node(std::move(value))),
+                                      std::memory_order_acq_rel);
+    Node* node = node_of(old);
+    if (!node) return shared_ptr<T, RefCount>();
+    // пока не перенесли закрепления, узел никто не удалит
+    shared_ptr<T, RefCount> result = node->value;
+    retire(node, static_cast<std::int64_t>(old >> 48));
+    return result;
+  }
+
+  // сравнивает и адрес, и владельца, как std::atomic<std::shared_ptr>;
+  // при неудаче кладёт текущее значение в expected. Читатели, которые
+  // закрепляют тот же узел, меняют только старшие биты -- из-за них CAS
+  // повторяется, но не проигрывается
+  bool compare_exchange_strong(shared_ptr<T, RefCount>& expected,
+                               shared_ptr<T, RefCount> desired) {
+    Node* fresh = nullptr;
+    while (true) {
+      std::uint64_t current = pin();
+      Node* node = node_of(current);
+      if (!same(node, expected)) {
+        expected = node ? node->value : shared_ptr<T, RefCount>();
+        if (node) unpin(node);
+        delete fresh;
+        return false;
+      }
+      if (!fresh) fresh = make_node(std::move(desired));
+      do {
+        if (word.compare_exchange_weak(current, pack(fresh),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+          // своё закрепление снимаем вместе с переносом
+          if (node) {
+            retire(node, static_cast<std::int64_t>(current >> 48) - 1);
+          }
+          return true;
+        }
+      } while (node_of(current) == node);
+      if (node) unpin(node);
+    }
+  }
+
+  bool compare_exchange_weak(shared_ptr<T, RefCount>& expected,
+                             shared_ptr<T, RefCount> desired) {
+    return compare_exchange_strong(expected, std::move(desired));
+  }
 };
 
+// одна аллокация на объект и счётчик
 template <typename T>
 shared_ptr<T> make_shared() {
-  return shared_ptr<T>(new T());
+  auto* block = new InplaceControlBlock<T, AtomicCount>();
+  return shared_ptr<T>(block->object(), block);
 }
 
 template <typename T, typename... Args>
 shared_ptr<T> make_shared(Args&&... args) {
-  return shared_ptr<T>(new T(std::forward<Args>(args)...));
+  auto* block =
+      new InplaceControlBlock<T, AtomicCount>(std::forward<Args>(args)...);
+  return shared_ptr<T>(block->object(), block);
 }
 
-// задача 3
-class bad_from_string : public std::exception {
+template <typename T, typename... Args>
+shared_ptr<T, LocalCount> make_local_shared(Args&&... args) {
+  auto* block =
+      new InplaceControlBlock<T, LocalCount>(std::forward<Args>(args)...);
+  return shared_ptr<T, LocalCount>(block->object(), block);
+}
+
+// intrusive_ptr: счётчик живёт в самом объекте, указатель -- одно слово,
+// без отдельного блока и лишней аллокации. Объект наследуется от
+// RefCounted<Self> (CRTP), последний intrusive_ptr удаляет его через Self
+template <typename Derived, typename RefCount = AtomicCount>
+class RefCounted {
+ public:
+  size_t use_count() const { return refs.load(); }
+
+ protected:
+  RefCounted() : refs(0) {}
+  // копия объекта -- новый объект, ссылок на него ещё нет
+  RefCounted(const RefCounted&) : refs(0) {}
+  RefCounted& operator=(const RefCounted&) { return *this; }
+  ~RefCounted() = default;
+
+ private:
+  mutable RefCount refs;
+
+  // находятся через ADL по указателю на наследника
+  friend void intrusive_add_ref(const RefCounted* p) { p->refs.increment(); }
+
+  friend void intrusive_release(const RefCounted* p) {
+    if (p->refs.decrement()) {
+      delete static_cast<const Derived*>(p);
+    }
+  }
+};
+
+template <typename T>
+class intrusive_ptr {
  private:
-  std::string message;
+  T* ptr;
+
+  template <typename U>
+  friend class intrusive_ptr;
 
  public:
-  bad_from_string() : message("bad_from_string error") {}
+  intrusive_ptr() : ptr(nullptr) {}
+
+  // годится и для this: счётчик уже внутри объекта
+  explicit intrusive_ptr(T* p) : ptr(p) {
+    if (ptr) {
+      intrusive_add_ref(ptr);
+    }
+  }
 
-  const char* what() const noexcept override { return message.c_str(); }
+  intrusive_ptr(const intrusive_ptr& other) : intrusive_ptr(other.ptr) {}
+
+  intrusive_ptr(intrusive_ptr&& other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)) {}
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  intrusive_ptr(const intrusive_ptr<U>& other) : intrusive_ptr(other.ptr) {}
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  intrusive_ptr(intrusive_ptr<U>&& other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)) {}
+
+  intrusive_ptr& operator=(const intrusive_ptr& other) {
+    intrusive_ptr(other).swap(*this);
+    return *this;
+  }
+
+  intrusive_ptr& operator=(intrusive_ptr&& other) noexcept {
+    intrusive_ptr(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~intrusive_ptr() {
+    if (ptr) {
+      intrusive_release(ptr);
+    }
+  }
+
+  T& operator*() const { return *ptr; }
+
+  T* operator->() const { return ptr; }
+
+  T* get() const { return ptr; }
+
+  explicit operator bool() const { return ptr != nullptr; }
+
+  void reset() { intrusive_ptr().swap(*this); }
+
+  void reset(T* p) { intrusive_ptr(p).swap(*this); }
+
+  void swap(intrusive_ptr& other) noexcept { std::swap(ptr, other.ptr); }
+};
+
+// задача 3
+class bad_from_string : public std::exception {
+ public:
+  const char* what() const noexcept override {
+    return error_message(ErrorCode::bad_from_string);
+  }
 };
 
+// числа разбираются через std::from_chars: без потока, локали и копии
+// строки; bool и символьные типы остаются на istringstream.
+// В отличие от потока double принимает "inf" и "nan", а беззнаковые
+// отвергают "-1" вместо заворачивания в максимум
 template <class T>
-T from_string(std::string const& s) {
-  std::istringstream is(s);
-  T tmp;
-  is >> std::noskipws >> tmp;
+constexpr bool is_from_chars_type_v =
+    (std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+     !std::is_same_v<T, char> && !std::is_same_v<T, signed char> &&
+     !std::is_same_v<T, unsigned char>) ||
+    std::is_floating_point_v<T>;
 
-  if (is.fail() || !is.eof()) {
-    throw bad_from_string();
+// true, если вся строка -- одно число
+template <class T>
+bool parse_number(std::string_view s, T& value) noexcept {
+  const char* first = s.data();
+  const char* last = first + s.size();
+  // istringstream принимал ведущий '+', from_chars -- нет
+  if (last - first > 1 && *first == '+' && first[1] != '-') ++first;
+  auto [ptr, ec] = std::from_chars(first, last, value);
+  return ec == std::errc() && ptr == last;
+}
+
+// для чисел не бросает вовсе; istringstream может бросить bad_alloc
+template <class T>
+Result<T> try_from_string(std::string_view s) noexcept(
+    is_from_chars_type_v<T>) {
+  T tmp;
+  if constexpr (is_from_chars_type_v<T>) {
+    if (!parse_number(s, tmp)) return ErrorCode::bad_from_string;
+  } else {
+    std::istringstream is{std::string(s)};
+    is >> std::noskipws >> tmp;
+
+    if (is.fail() || !is.eof()) {
+      return ErrorCode::bad_from_string;
+    }
   }
 
   return tmp;
 }
+
+template <class T>
+T from_string(std::string_view s) {
+  Result<T> result = try_from_string<T>(s);
+  if (!result) throw bad_from_string();
+  return std::move(*result);
+}
+
+// разделители поля для parse_all: до четырёх символов
+struct Separators {
+  char c[4];
+
+  bool contains(char ch) const {
+    return ch == c[0] || ch == c[1] || ch == c[2] || ch == c[3];
+  }
+
+#ifdef __SSE2__
+  // бит i -- байт p[i] разделитель
+  unsigned mask16(const char* p) const {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hit = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c[0]));
+    for (int i = 1; i < 4; ++i) {
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c[i])));
+    }
+    return static_cast<unsigned>(_mm_movemask_epi8(hit));
+  }
+#endif
+};
+
+inline size_t find_separator(std::string_view buf, size_t pos,
+                             const Separators& seps) {
+#ifdef __SSE2__
+  for (; pos + 16 <= buf.size(); pos += 16) {
+    if (unsigned mask = seps.mask16(buf.data() + pos)) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (pos < buf.size() && !seps.contains(buf[pos])) ++pos;
+  return pos;
+}
+
+// число непустых полей: начало поля -- не разделитель после разделителя
+inline size_t count_fields(std::string_view buf, const Separators& seps) {
+  size_t count = 0;
+  size_t i = 0;
+  unsigned prev_sep = 1;
+#ifdef __SSE2__
+  for (; i + 16 <= buf.size(); i += 16) {
+    unsigned sep = seps.mask16(buf.data() + i);
+    count += __builtin_popcount(~sep & ((sep << 1) | prev_sep) & 0xFFFF);
+    prev_sep = sep >> 15;
+  }
+#endif
+  for (; i < buf.size(); ++i) {
+    unsigned sep = seps.contains(buf[i]);
+    count += prev_sep & ~sep & 1;
+    prev_sep = sep;
+  }
+  return count;
+}
+
+// разбирает весь буфер в один массив. delim == ' ' -- поля разделены любыми
+// пробельными символами; иначе delim или концом строки (CSV целиком,
+// построчно), пустое поле между delim -- ошибка. Пустые строки пропускаются
+template <class T>
+std::vector<T> parse_all(std::string_view buf, char delim = ' ') {
+  static_assert(is_from_chars_type_v<T>, "parse_all supports numbers only");
+  bool const spaces = delim == ' ';
+  Separators const seps =
+      spaces ? Separators{{' ', '\t', '\n', '\r'}}
+             : Separators{{delim, '\n', '\r', '\n'}};
+  auto const line_break = [&](char ch) {
+    return spaces ? seps.contains(ch) : ch == '\n' || ch == '\r';
+  };
+
+  std::vector<T> out;
+  out.reserve(count_fields(buf, seps));
+  size_t pos = 0;
+  while (true) {
+    while (pos < buf.size() && line_break(buf[pos])) ++pos;
+    if (pos == buf.size()) break;
+    size_t const end = find_separator(buf, pos, seps);
+    T value;
+    if (!parse_number(buf.substr(pos, end - pos), value)) {
+      throw bad_from_string();
+    }
+    out.push_back(value);
+    pos = end;
+    if (!spaces && pos < buf.size() && buf[pos] == delim) {
+      ++pos;
+      if (pos == buf.size() || seps.contains(buf[pos])) {
+        throw bad_from_string();
+      }
+    }
+  }
+  return out;
+}
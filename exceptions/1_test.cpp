@@ -0,0 +1,379 @@
+#include "1.cpp"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// задача 1: Result, try_divide и сообщения исключений
+void test_result_and_divide() {
+  static_assert(2 == *try_divide(7, 3));
+  static_assert(ErrorCode::overflow == try_divide(1, 0).error());
+  constexpr int int_min = std::numeric_limits<int>::min();
+  static_assert(!try_divide(int_min, -1));
+  static_assert(int_min == *try_divide(int_min, 1));
+  static_assert(-5 == try_divide(1, 0).value_or(-5));
+
+  Result<std::string> text = std::string("abc");
+  assert(text.has_value() && 3 == text->size() && "abc" == *text);
+  Result<std::string> failed = ErrorCode::bad_from_string;
+  assert(!failed && ErrorCode::bad_from_string == failed.error());
+  assert("x" == failed.value_or("x"));
+
+  bool thrown = false;
+  try {
+    divide(int_min, -1);
+  } catch (const OverflowError& e) {
+    thrown = std::string(e.what()) == "overflow error";
+  }
+  assert(thrown);
+  assert(-3 == divide(7, -2));
+
+  // строка вызывающего переживает копирование исключения
+  std::string message = "custom";
+  MathException custom = message;
+  message.clear();
+  MathException copy = custom;
+  assert(std::string(copy.what()) == "custom");
+  assert(std::string(MathException().what()) == "math error");
+  // строка, собранная во время работы, копируется и через const char*
+  std::string runtime = "built at " + std::to_string(42);
+  MathException from_c_str(runtime.c_str());
+  runtime.assign(runtime.size(), 'x');
+  assert(std::string(from_c_str.what()) == "built at 42");
+  static_assert(!std::is_constructible_v<MathException, ErrorCode>);
+  assert(std::string(UnderflowError().what()) == "underflow error");
+
+  static_assert(noexcept(try_from_string<int>("1")));
+  assert(42 == *try_from_string<int>("42"));
+  assert(ErrorCode::bad_from_string == try_from_string<int>("4 2").error());
+  assert(!try_from_string<int>("99999999999"));
+  assert(2.5 == try_from_string<double>("2.5").value_or(0));
+}
+
+// задача 2: политики счётчика
+void test_ref_count_policies() {
+  static_assert(is_thread_safe_v<shared_ptr<int>>);
+  static_assert(!is_thread_safe_v<local_shared_ptr<int>>);
+  static_assert(!std::is_convertible_v<local_shared_ptr<int>,
+                                       shared_ptr<int>>);
+
+  LocalCount local(1);
+  local.increment();
+  assert(2 == local.load());
+  assert(!local.decrement() && local.decrement());
+  assert(!local.increment_if_nonzero() && 0 == local.load());
+
+  AtomicCount atomic(1);
+  assert(atomic.increment_if_nonzero() && 2 == atomic.load());
+  assert(!atomic.decrement() && atomic.decrement());
+  assert(!atomic.increment_if_nonzero());
+
+  local_shared_ptr<int> l = make_local_shared<int>(5);
+  local_shared_ptr<int> l2 = l;
+  assert(5 == *l2 && 2 == l.use_count());
+  l.reset();
+  assert(l2.unique());
+
+  // копии из нескольких потоков: счётчик сходится, объект удаляется ровно раз
+  shared_ptr<int> shared = make_shared<int>(7);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([shared] {
+      for (int i = 0; i < 10000; ++i) {
+        shared_ptr<int> copy = shared;
+        assert(7 == *copy);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  assert(shared.unique());
+}
+
+struct Holder {
+  shared_ptr<int> p;
+};
+
+// блоки пула переиспользуются; shared_ptr в thread_local, который
+// разрушается уже после списка свободных блоков, освобождает свой блок мимо
+// списка
+void test_block_pool() {
+  void* block = BlockPool<32>::allocate();
+  BlockPool<32>::deallocate(block);
+  assert(block == BlockPool<32>::allocate());
+  BlockPool<32>::deallocate(block);
+
+  std::thread([] {
+    thread_local Holder holder;
+    shared_ptr<int>(new int(3)).reset();
+    holder.p = shared_ptr<int>(new int(4));
+  }).join();
+}
+
+struct Base {
+  int base = 1;
+  virtual ~Base() = default;
+};
+
+struct Derived : Base {
+  static int alive;
+  int field = 2;
+  Derived() { ++alive; }
+  ~Derived() override { --alive; }
+};
+
+int Derived::alive = 0;
+
+void test_weak_and_aliasing() {
+  weak_ptr<Base> weak;
+  {
+    shared_ptr<Derived> owner = make_shared<Derived>();
+    weak = weak_ptr<Base>(owner);
+    assert(!weak.expired() && 1 == weak.use_count());
+    shared_ptr<Base> locked = weak.lock();
+    assert(locked && 2 == owner.use_count() && 1 == locked->base);
+  }
+  assert(0 == Derived::alive);
+  assert(weak.expired() && !weak.lock() && 0 == weak.lock().use_count());
+  weak.reset();
+
+  // aliasing: указатель на поле держит весь объект
+  shared_ptr<int> field;
+  {
+    shared_ptr<Derived> owner(new Derived);
+    field = shared_ptr<int>(owner, &owner->field);
+    assert(2 == owner.use_count());
+  }
+  assert(1 == Derived::alive && 2 == *field && field.unique());
+  weak_ptr<int> weak_field(field);
+  shared_ptr<int> moved(std::move(field), field.get());
+  assert(!field && moved.unique() && 2 == *weak_field.lock());
+  moved.reset();
+  assert(0 == Derived::alive && weak_field.expired());
+
+  shared_ptr<Derived> d = make_shared<Derived>();
+  shared_ptr<Base> b = d;
+  shared_ptr<Base> b2 = std::move(d);
+  assert(!d && 2 == b.use_count() && b.get() == b2.get());
+}
+
+struct Counted {
+  static std::atomic<int> alive;
+  int value;
+  explicit Counted(int v) : value(v) { ++alive; }
+  ~Counted() { --alive; }
+};
+
+std::atomic<int> Counted::alive{0};
+
+// CAS-инкременты из нескольких потоков не теряются; читатели при store
+// видят значения по порядку; после всего не остаётся ни одного объекта
+void test_atomic_shared_ptr() {
+  constexpr int threads = 4;
+  constexpr int rounds = 2000;
+  using Ptr = shared_ptr<Counted>;
+  {
+    atomic_shared_ptr<Counted> slot(Ptr(new Counted(0)));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&slot] {
+        for (int i = 0; i < rounds; ++i) {
+          Ptr expected = slot.load();
+          while (!slot.compare_exchange_weak(
+              expected, Ptr(new Counted(expected->value + 1)))) {
+          }
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    assert(threads * rounds == slot.load()->value);
+
+    for (int t = 1; t < threads; ++t) {
+      workers.emplace_back([&slot] {
+        int last = 0;
+        while (last != 2 * threads * rounds) {
+          Ptr seen = slot.load();
+          assert(seen->value >= last);
+          last = seen->value;
+        }
+      });
+    }
+    for (int i = threads * rounds + 1; i <= 2 * threads * rounds; ++i) {
+      slot.store(Ptr(new Counted(i)));
+    }
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+
+    // внешний счётчик много раз переполнил бы 16 бит без переноса
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&slot] {
+        for (int i = 0; i < 40000; ++i) {
+          Ptr seen = slot.load();
+          assert(2 * threads * rounds == seen->value);
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+    assert(2 == slot.load().use_count());
+
+    Ptr old = slot.exchange(Ptr());
+    assert(old && old.unique() && !slot.load());
+    Ptr expected;
+    assert(slot.compare_exchange_strong(expected, old));
+    assert(2 == old.use_count());
+    assert(!slot.compare_exchange_strong(expected, Ptr()));
+    assert(expected.get() == old.get());
+  }
+  assert(0 == Counted::alive);
+}
+
+struct Shape : RefCounted<Shape> {
+  static int alive;
+  Shape() { ++alive; }
+  Shape(const Shape& other) : RefCounted<Shape>(other) { ++alive; }
+  virtual ~Shape() { --alive; }
+
+  intrusive_ptr<Shape> self() { return intrusive_ptr<Shape>(this); }
+};
+
+struct Circle : Shape {};
+
+int Shape::alive = 0;
+
+// каждый add_ref уравновешен release: объект удаляется ровно тогда,
+// когда уходит последний указатель
+void test_intrusive_ptr() {
+  {
+    intrusive_ptr<Circle> circle(new Circle);
+    assert(1 == circle->use_count());
+    intrusive_ptr<Shape> shape = circle;
+    intrusive_ptr<Shape> from_this = circle->self();
+    assert(3 == circle->use_count());
+    intrusive_ptr<Shape> moved = std::move(shape);
+    assert(!shape && 3 == circle->use_count());
+    moved = from_this;
+    assert(3 == circle->use_count());
+    from_this.reset();
+    moved.reset();
+    assert(1 == circle->use_count() && 1 == Shape::alive);
+
+    // копия объекта получает свой счётчик
+    Circle copy(*circle);
+    assert(0 == copy.use_count() && 2 == Shape::alive);
+
+    intrusive_ptr<Shape> other(new Shape);
+    other.reset(circle.get());
+    assert(2 == circle->use_count() && 2 == Shape::alive);
+    other = intrusive_ptr<Shape>(std::move(circle));
+    assert(!circle && 1 == other->use_count());
+  }
+  assert(0 == Shape::alive);
+}
+
+// from_chars вместо istringstream: "inf"/"nan" для double, без "-1" для
+// беззнаковых, '+' только перед цифрой
+void test_from_string() {
+  assert(std::isinf(from_string<double>("inf")));
+  assert(std::isinf(from_string<double>("-inf")));
+  assert(std::isnan(from_string<double>("nan")));
+  assert(1.5 == from_string<double>("+1.5"));
+  assert(1000.0 == from_string<float>("1e3"));
+  assert(!try_from_string<unsigned>("-1"));
+  assert(!try_from_string<unsigned long long>("-0"));
+  assert(7u == from_string<unsigned>("+7"));
+  assert(-7 == from_string<int>("-7"));
+  for (const char* bad : {"", "+", "+-1", "++1", " 1", "1 ", "1x", "0x10"}) {
+    assert(!try_from_string<int>(bad) && !try_from_string<double>(bad));
+  }
+  assert(!try_from_string<signed char>("300"));
+  assert(from_string<bool>("1"));
+
+  bool thrown = false;
+  try {
+    from_string<unsigned>("-1");
+  } catch (const bad_from_string&) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+// поля по одному разделителю, без SSE2
+std::vector<double> split_naive(const std::string& s, char delim) {
+  std::vector<double> out;
+  std::string field;
+  for (char ch : s + delim) {
+    if (ch == delim || ch == ' ' || ch == '\t' || ch == '\n') {
+      if (!field.empty()) out.push_back(std::stod(field));
+      field.clear();
+    } else {
+      field += ch;
+    }
+  }
+  return out;
+}
+
+// разделители на краях 16-байтовых кусков и сразу за ними
+void test_parse_all() {
+  for (size_t p = 0; p + 1 < 50; ++p) {
+    std::string s(50, '7');
+    s[p] = ' ';
+    s[p + 1] = '\t';
+    s[(p + 17) % 50] = '\n';
+    s[49 - p / 3] = ' ';
+    std::vector<double> expected = split_naive(s, ' ');
+    assert(parse_all<double>(s) == expected);
+    assert(count_fields(s, Separators{{' ', '\t', '\n', '\r'}}) ==
+           expected.size());
+
+    std::string csv(50, '1');
+    csv[p] = ',';
+    if (p + 17 < 50) csv[p + 17] = '\n';
+    std::vector<double> fields = split_naive(csv, ',');
+    if (p == 0) {
+      // пустое первое поле
+      bool thrown = false;
+      try {
+        parse_all<double>(csv, ',');
+      } catch (const bad_from_string&) {
+        thrown = true;
+      }
+      assert(thrown);
+    } else {
+      assert(parse_all<double>(csv, ',') == fields);
+    }
+  }
+
+  for (const char* bad : {"1,,2", "1,\n2", "1,"}) {
+    bool thrown = false;
+    try {
+      parse_all<int>(bad, ',');
+    } catch (const bad_from_string&) {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+  assert((parse_all<double>("inf\n\n-1.5,2\r\n", ',') ==
+          std::vector<double>{std::numeric_limits<double>::infinity(), -1.5,
+                              2}));
+  assert(parse_all<int>("").empty() && parse_all<int>(" \n\t ").empty());
+}
+
+}  // namespace
+
+int main() {
+  test_result_and_divide();
+  test_ref_count_policies();
+  test_block_pool();
+  test_weak_and_aliasing();
+  test_atomic_shared_ptr();
+  test_intrusive_ptr();
+  test_from_string();
+  test_parse_all();
+  return 0;
+}
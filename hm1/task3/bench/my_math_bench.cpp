@@ -0,0 +1,267 @@
+#include "../include/my_math.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// точность и скорость my_sin/my_cos/my_tan против libm. Эталон -- sinl/
+// cosl/tanl (80-битный long double), ошибка -- в ulp эталона, округлённого
+// до double. Одна строка на (функция, реализация, диапазон):
+// function,impl,range,samples,max_ulp,mean_ulp,max_abs_err,ns_per_call,
+// calls_per_ns
+// --format json -- то же массивом объектов; --min-time-ms -- время замера
+
+namespace {
+
+// не даёт компилятору выбросить вычисленное значение
+template <typename T>
+void keep(T const& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Range {
+  const char* name;
+  std::vector<double> xs;
+};
+
+std::vector<Range> make_ranges(std::size_t n) {
+  std::mt19937_64 gen(2024);
+  auto uniform = [&](double lo, double hi) {
+    std::uniform_real_distribution<double> dist(lo, hi);
+    std::vector<double> xs(n);
+    for (double& x : xs) x = dist(gen);
+    return xs;
+  };
+
+  std::vector<Range> ranges;
+  ranges.push_back({"pi/4", uniform(-M_PI / 4, M_PI / 4)});
+  ranges.push_back({"1e2", uniform(-1e2, 1e2)});
+  ranges.push_back({"1e6", uniform(-1e6, 1e6)});
+
+  // |x| от 1e6 до 1e300, равномерно по порядку -- Payne-Hanek
+  std::vector<double> huge = uniform(6, 300);
+  for (std::size_t i = 0; i < n; ++i) {
+    huge[i] = std::pow(10.0, huge[i]) * ((i & 1) ? -1 : 1);
+  }
+  ranges.push_back({"huge", std::move(huge)});
+
+  // рядом с (k + 1/2) pi: нули cos и полюса tan
+  std::uniform_int_distribution<int> k(-10000, 10000);
+  std::uniform_real_distribution<double> offset(-1e-6, 1e-6);
+  std::vector<double> pole(n);
+  for (double& x : pole) x = (k(gen) + 0.5) * M_PI + offset(gen);
+  ranges.push_back({"near_pole", std::move(pole)});
+  return ranges;
+}
+
+enum class Func { sin, cos, tan };
+
+const char* func_name(Func f) {
+  switch (f) {
+    case Func::sin:
+      return "sin";
+    case Func::cos:
+      return "cos";
+    case Func::tan:
+      return "tan";
+  }
+  return "?";
+}
+
+long double reference(Func f, double x) {
+  switch (f) {
+    case Func::sin:
+      return sinl(x);
+    case Func::cos:
+      return cosl(x);
+    case Func::tan:
+      return tanl(x);
+  }
+  return 0;
+}
+
+// out[i] = f(in[i]) для всего массива
+using Eval = void (*)(Func, const double*, double*, std::size_t);
+
+void eval_std(Func f, const double* in, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = f == Func::sin   ? std::sin(in[i])
+             : f == Func::cos ? std::cos(in[i])
+                              : std::tan(in[i]);
+  }
+}
+
+void eval_scalar(Func f, const double* in, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = f == Func::sin   ? my_sin(in[i]).result
+             : f == Func::cos ? my_cos(in[i]).result
+                              : my_tan(in[i]).result;
+  }
+}
+
+void eval_batch(Func f, const double* in, double* out, std::size_t n) {
+  switch (f) {
+    case Func::sin:
+      return my_sin(in, out, n);
+    case Func::cos:
+      return my_cos(in, out, n);
+    case Func::tan:
+      return my_tan(in, out, n);
+  }
+}
+
+template <Accuracy A>
+void eval_tier(Func f, const double* in, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = f == Func::sin   ? my_sin<A>(in[i])
+             : f == Func::cos ? my_cos<A>(in[i])
+                              : my_tan<A>(in[i]);
+  }
+}
+
+struct Impl {
+  const char* name;
+  Eval eval;
+};
+
+struct Row {
+  std::string function, impl, range;
+  std::size_t samples;
+  double max_ulp, mean_ulp, max_abs_err, ns_per_call;
+};
+
+double ulp_error(double y, long double ref) {
+  double const r = static_cast<double>(ref);
+  if (std::isnan(y) || std::isnan(r)) {
+    return std::isnan(y) == std::isnan(r) ? 0 : INFINITY;
+  }
+  double const ulp = std::nextafter(std::abs(r), INFINITY) - std::abs(r);
+  return static_cast<double>(std::abs(static_cast<long double>(y) - ref) /
+                             ulp);
+}
+
+// лучшее из пяти время прохода по массиву, каждый замер не короче min_ns
+double measure(Impl const& impl, Func f, std::vector<double> const& xs,
+               std::vector<double>& out, double min_ns) {
+  using clock = std::chrono::steady_clock;
+  double best = INFINITY;
+  for (int repeat = 0; repeat < 5; ++repeat) {
+    std::size_t iterations = 0;
+    auto const start = clock::now();
+    double elapsed = 0;
+    do {
+      impl.eval(f, xs.data(), out.data(), xs.size());
+      keep(out[iterations % out.size()]);
+      ++iterations;
+      elapsed =
+          std::chrono::duration<double, std::nano>(clock::now() - start)
+              .count();
+    } while (elapsed < min_ns);
+    best = std::min(best, elapsed / static_cast<double>(iterations));
+  }
+  return best / static_cast<double>(xs.size());
+}
+
+void print_csv(std::vector<Row> const& rows) {
+  std::printf(
+      "function,impl,range,samples,max_ulp,mean_ulp,max_abs_err,ns_per_call,"
+      "calls_per_ns\n");
+  for (Row const& r : rows) {
+    std::printf("%s,%s,%s,%zu,%.3f,%.4f,%.3e,%.3f,%.4f\n", r.function.c_str(),
+                r.impl.c_str(), r.range.c_str(), r.samples, r.max_ulp,
+                r.mean_ulp, r.max_abs_err, r.ns_per_call, 1.0 / r.ns_per_call);
+  }
+}
+
+// inf в JSON не бывает -- пишется null
+void print_number(double v, const char* format) {
+  if (std::isfinite(v)) {
+    std::printf(format, v);
+  } else {
+    std::printf("null");
+  }
+}
+
+void print_json(std::vector<Row> const& rows) {
+  std::printf("[\n");
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    Row const& r = rows[i];
+    std::printf(
+        "  {\"function\": \"%s\", \"impl\": \"%s\", \"range\": \"%s\", "
+        "\"samples\": %zu, \"max_ulp\": ",
+        r.function.c_str(), r.impl.c_str(), r.range.c_str(), r.samples);
+    print_number(r.max_ulp, "%.3f");
+    std::printf(", \"mean_ulp\": ");
+    print_number(r.mean_ulp, "%.4f");
+    std::printf(", \"max_abs_err\": ");
+    print_number(r.max_abs_err, "%.3e");
+    std::printf(", \"ns_per_call\": %.3f, \"calls_per_ns\": %.4f}%s\n",
+                r.ns_per_call, 1.0 / r.ns_per_call,
+                i + 1 < rows.size() ? "," : "");
+  }
+  std::printf("]\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  bool json = false;
+  double min_ns = 50e6;
+  std::size_t samples = 1 << 16;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      json = std::strcmp(argv[++i], "json") == 0;
+    } else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+      min_ns = std::strtod(argv[++i], nullptr) * 1e6;
+    } else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      samples = std::strtoull(argv[++i], nullptr, 10);
+    }
+  }
+
+  std::string const batch_name = std::string("batch_") + my_math_batch_isa();
+  Impl const impls[] = {
+      {"std", eval_std},
+      {"scalar", eval_scalar},
+      {batch_name.c_str(), eval_batch},
+      {"taylor3", eval_tier<Accuracy::taylor3>},
+      {"linear", eval_tier<Accuracy::linear>},
+  };
+
+  std::vector<Row> rows;
+  std::vector<double> out(samples);
+  for (Range const& range : make_ranges(samples)) {
+    for (Func f : {Func::sin, Func::cos, Func::tan}) {
+      std::vector<long double> ref(samples);
+      for (std::size_t i = 0; i < samples; ++i) {
+        ref[i] = reference(f, range.xs[i]);
+      }
+      for (Impl const& impl : impls) {
+        impl.eval(f, range.xs.data(), out.data(), samples);
+        Row row{func_name(f), impl.name, range.name, samples, 0, 0, 0, 0};
+        for (std::size_t i = 0; i < samples; ++i) {
+          double const ulp = ulp_error(out[i], ref[i]);
+          row.max_ulp = std::max(row.max_ulp, ulp);
+          row.mean_ulp += ulp / static_cast<double>(samples);
+          row.max_abs_err = std::max(
+              row.max_abs_err,
+              static_cast<double>(std::abs(out[i] - ref[i])));
+        }
+        row.ns_per_call = measure(impl, f, range.xs, out, min_ns);
+        rows.push_back(row);
+      }
+    }
+  }
+
+  if (json) {
+    print_json(rows);
+  } else {
+    print_csv(rows);
+  }
+  return 0;
+}
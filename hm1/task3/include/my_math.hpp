@@ -1,10 +1,154 @@
 #ifndef MY_MATH_HPP
 #define MY_MATH_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
 #include "ans_handler.hpp"
+#include "trig_kernels.hpp"
 
 AnswerHandler my_sin(double x);
 AnswerHandler my_cos(double x);
 AnswerHandler my_tan(double x);
 
+struct SinCos {
+  double x;
+  double sin;
+  double cos;
+};
+
+// sin и cos за одно приведение аргумента
+SinCos my_sincos(double x);
+
+// пакетные версии: out[i] = f(in[i]) для i < n, in и out могут совпадать.
+// Ядро (AVX-512, AVX2+FMA или скалярное) выбирается при первом вызове
+void my_sin(const double* in, double* out, std::size_t n);
+void my_cos(const double* in, double* out, std::size_t n);
+void my_tan(const double* in, double* out, std::size_t n);
+void my_sincos(const double* in, double* sin_out, double* cos_out,
+               std::size_t n);
+
+// выбранное ядро: "avx512", "avx2" или "scalar"
+const char* my_math_batch_isa();
+
+// уровни точности для my_sin<A>, my_cos<A>, my_tan<A>; все constexpr.
+// full    -- тот же результат, что my_sin(x); при компиляции -- только
+//            для |x| <= 1e6 (Cody-Waite), иначе ошибка компиляции
+// taylor3 -- таблица на период + ряд Тейлора 3-й степени в ближайшем
+//            узле (не интерполяция между узлами), ошибка ~4e-12
+// linear  -- та же таблица, 1-я степень, ошибка ~5e-6
+// Аргумент приводится так же, как в my_sin, поэтому ошибка табличных
+// уровней от |x| не зависит; ограничение при компиляции -- как у full.
+// Табличные уровни без ветвлений по квадранту и выигрывают на произвольных
+// x; при |x| <= pi/4 ветвление предсказуемо и full не медленнее
+enum class Accuracy { linear, taylor3, full };
+
+namespace trig {
+
+constexpr int table_size = 1024;
+constexpr double pi = 3.14159265358979311600e+00;
+
+struct SinTable {
+  double v[table_size];
+};
+
+// sin(2 pi i / table_size), считается при компиляции
+constexpr SinTable make_sin_table() {
+  SinTable table{};
+  for (int i = 0; i < table_size; ++i) {
+    double r = 0.0;
+    unsigned q = reduce_cody_waite(2.0 * pi * i / table_size, r);
+    table.v[i] = sin_quadrant(q, r, 0.0);
+  }
+  return table;
+}
+
+inline constexpr SinTable sin_table = make_sin_table();
+
+// полная точность при компиляции; в рантайме -- обычный путь
+constexpr void constexpr_reduce(double x, double& r, unsigned& q) {
+  if (!(x <= cody_waite_limit && x >= -cody_waite_limit)) {
+    throw std::domain_error("constexpr trig needs |x| <= 1e6");
+  }
+  q = reduce_cody_waite(x, r);
+}
+
+// Cody-Waite без FMA: табличные уровни встраиваются в код пользователя, где
+// std::fma без -mfma -- вызов libm, а трёх частей pi/2 хватает с запасом
+constexpr unsigned reduce_table(double x, double& r) {
+  double const k = (x * two_over_pi + round_magic) - round_magic;
+  r = ((x - k * pio2_1) - k * pio2_2) - k * pio2_3;
+  return static_cast<unsigned>(static_cast<std::int64_t>(k) & 3);
+}
+
+// sin(x + shift * 2 pi / table_size); cos -- сдвиг на четверть таблицы.
+// x = q pi/2 + j h + d, |d| <= h/2, и sin(a + d) = sin a cos d + cos a sin d,
+// где sin a и cos a -- из таблицы. Отброшенное: d^2/2 или d^4/24
+template <Accuracy A>
+constexpr double table_sin(double x, int shift) {
+  constexpr int mask = table_size - 1;
+  constexpr double h = 2.0 * pi / table_size;
+  double r = 0.0;
+  unsigned q = 0;
+  if (x <= cody_waite_limit && x >= -cody_waite_limit) {
+    q = reduce_table(x, r);
+  } else if (__builtin_is_constant_evaluated()) {
+    throw std::domain_error("constexpr trig needs |x| <= 1e6");
+  } else {
+    double dr = 0.0;
+    q = reduce(x, r, dr);
+    if (r != r) return r;
+  }
+  double const j =
+      (r * (table_size / (2.0 * pi)) + round_magic) - round_magic;
+  double const d = r - j * h;
+  int const a = (static_cast<int>(j) + static_cast<int>(q) * table_size / 4 +
+                 shift) & mask;
+  double const s = sin_table.v[a];
+  double const c = sin_table.v[(a + table_size / 4) & mask];
+  if constexpr (A == Accuracy::linear) {
+    return s + c * d;
+  } else {
+    double const d2 = d * d;
+    return s * (1.0 - 0.5 * d2) + c * d * (1.0 - d2 * (1.0 / 6));
+  }
+}
+
+}  // namespace trig
+
+template <Accuracy A>
+constexpr double my_sin(double x) {
+  if constexpr (A == Accuracy::full) {
+    if (!__builtin_is_constant_evaluated()) return my_sin(x).result;
+    double r = 0.0;
+    unsigned q = 0;
+    trig::constexpr_reduce(x, r, q);
+    return trig::sin_quadrant(q, r, 0.0);
+  } else {
+    return trig::table_sin<A>(x, 0);
+  }
+}
+
+template <Accuracy A>
+constexpr double my_cos(double x) {
+  if constexpr (A == Accuracy::full) {
+    if (!__builtin_is_constant_evaluated()) return my_cos(x).result;
+    double r = 0.0;
+    unsigned q = 0;
+    trig::constexpr_reduce(x, r, q);
+    return trig::cos_quadrant(q, r, 0.0);
+  } else {
+    return trig::table_sin<A>(x, trig::table_size / 4);
+  }
+}
+
+template <Accuracy A>
+constexpr double my_tan(double x) {
+  if constexpr (A == Accuracy::full) {
+    if (!__builtin_is_constant_evaluated()) return my_tan(x).result;
+  }
+  return my_sin<A>(x) / my_cos<A>(x);
+}
+
 #endif
@@ -0,0 +1,26 @@
+#ifndef STREAM_EVAL_HPP
+#define STREAM_EVAL_HPP
+
+#include <cstddef>
+#include <cstdio>
+
+struct StreamOptions {
+  // вход -- сырые double подряд, иначе текст: числа через пробельные символы
+  bool binary_in = false;
+  // выход -- четвёрки double (x, sin, cos, tan), иначе строки
+  // "x sin cos tan" в кратчайшей точной записи
+  bool binary_out = false;
+  // потоки для разбора, вычислений и форматирования; 0 -- по числу ядер
+  unsigned threads = 0;
+  // байт входа в одном блоке
+  std::size_t block_bytes = std::size_t{4} << 20;
+};
+
+// поток x из in -> sin/cos/tan в out блоками. Чтение, вычисление и запись
+// идут одновременно, порядок результатов совпадает с порядком входа.
+// Значения побитно совпадают с my_sin/my_cos/my_tan.
+// in читается напрямую через дескриптор, мимо буфера FILE.
+// Ошибки разбора и ввода-вывода -- std::runtime_error
+void stream_eval(std::FILE* in, std::FILE* out, StreamOptions const& options);
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef TRIG_KERNELS_HPP
+#define TRIG_KERNELS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// общее для скалярных и векторных ядер: константы приведения аргумента
+// и минимаксные многочлены на [-pi/4, pi/4] (коэффициенты из fdlibm)
+namespace trig {
+
+// std::fma без -mfma -- вызов libm; скалярные точки входа поэтому
+// собираются в двух вариантах, нужный выбирается при загрузке
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TRIG_FMA_CLONES __attribute__((target_clones("fma", "default")))
+#else
+#define TRIG_FMA_CLONES
+#endif
+
+constexpr double two_over_pi = 6.36619772367581382433e-01;
+
+// pi/2 = pio2_1 + pio2_2 + pio2_3 + pio2_3t; в первых трёх по 33 бита,
+// так что k * pio2_i точно при |k| < 2^20 (Cody-Waite)
+constexpr double pio2_1 = 1.57079632673412561417e+00;
+constexpr double pio2_2 = 6.07710050630396597660e-11;
+constexpr double pio2_3 = 2.02226624871116645580e-21;
+constexpr double pio2_3t = 8.47842766036889956997e-32;
+
+// дальше Cody-Waite теряет точность
+constexpr double cody_waite_limit = 1.0e6;
+
+// 1.5 * 2^52: x + magic округляет x до целого, и оно оказывается
+// в младших битах мантиссы
+constexpr double round_magic = 6755399441055744.0;
+
+constexpr double S1 = -1.66666666666666324348e-01;
+constexpr double S2 = 8.33333333332248946124e-03;
+constexpr double S3 = -1.98412698298579493134e-04;
+constexpr double S4 = 2.75573137070700676789e-06;
+constexpr double S5 = -2.50507602534068634195e-08;
+constexpr double S6 = 1.58969099521155010221e-10;
+
+constexpr double C1 = 4.16666666666666019037e-02;
+constexpr double C2 = -1.38888888888741095749e-03;
+constexpr double C3 = 2.48015872894767294178e-05;
+constexpr double C4 = -2.75573143513906633035e-07;
+constexpr double C5 = 2.08757232129817482790e-09;
+constexpr double C6 = -1.13596475577881948265e-11;
+
+// все ядра считают одними и теми же FMA в одном порядке, поэтому скалярный
+// путь, хвост пакета и векторные дорожки дают одинаковые биты. GCC
+// вычисляет std::fma и при компиляции
+// sin(r), |r| <= pi/4
+constexpr double sin_poly(double r) {
+  double z = r * r;
+  double p = std::fma(z, S6, S5);
+  p = std::fma(z, p, S4);
+  p = std::fma(z, p, S3);
+  p = std::fma(z, p, S2);
+  p = std::fma(z, p, S1);
+  return std::fma(r * z, p, r);
+}
+
+// cos(r), |r| <= pi/4
+constexpr double cos_poly(double r) {
+  double z = r * r;
+  double p = std::fma(z, C6, C5);
+  p = std::fma(z, p, C4);
+  p = std::fma(z, p, C3);
+  p = std::fma(z, p, C2);
+  p = std::fma(z, p, C1);
+  return std::fma(z * z, p, std::fma(-0.5, z, 1.0));
+}
+
+// x = q * pi/2 + r, |r| <= pi/4; верно при |x| <= cody_waite_limit.
+// Возвращает q по модулю 4; годится и для вычисления при компиляции
+constexpr unsigned reduce_cody_waite(double x, double& r) {
+  double const k = std::fma(x, two_over_pi, round_magic) - round_magic;
+  r = std::fma(-k, pio2_1, x);
+  r = std::fma(-k, pio2_2, r);
+  r = std::fma(-k, pio2_3, r);
+  r = std::fma(-k, pio2_3t, r);
+  return static_cast<unsigned>(static_cast<std::int64_t>(k) & 3);
+}
+
+// биты 2/pi после запятой, по 64 в слове; первое слово -- нули перед
+// запятой, чтобы окно не уходило за начало таблицы при x около 2^20
+inline constexpr std::uint64_t two_over_pi_bits[] = {
+    0x0000000000000000ull, 0xa2f9836e4e441529ull, 0xfc2757d1f534ddc0ull,
+    0xdb6295993c439041ull, 0xfe5163abdebbc561ull, 0xb7246e3a424dd2e0ull,
+    0x06492eea09d1921cull, 0xfe1deb1cb129a73eull, 0xe88235f52ebb4484ull,
+    0xe99c7026b45f7e41ull, 0x3991d639835339f4ull, 0x9c845f8bbdf9283bull,
+    0x1ff897ffde05980full, 0xef2f118b5a0a6d1full, 0x6d367ecf27cb09b7ull,
+    0x4f463f669e5fea2dull, 0x7527bac7ebe5f17bull, 0x3d0739f78a5292eaull,
+    0x6bfb5fb11f8d5d08ull, 0x56033046fc7b6babull, 0xf0cfbc209af4361dull,
+};
+
+// pi/2 = pio2_hi + pio2_lo
+constexpr double pio2_hi = 1.57079632679489655800e+00;
+constexpr double pio2_lo = 6.12323399573676603587e-17;
+
+// v = hi + lo с точностью до округления lo. hi может округлиться вверх до
+// 2^127, которого в __int128 нет, поэтому разность берётся по модулю 2^128:
+// сама она мала (|v - hi| <= 2^73) и обратно переводится без переполнения
+inline void split_int128(__int128 v, double& hi, double& lo) {
+  using u128 = unsigned __int128;
+  hi = static_cast<double>(v);
+  u128 const hi_bits =
+      hi < 0 ? -static_cast<u128>(-hi) : static_cast<u128>(hi);
+  lo = static_cast<double>(static_cast<__int128>(static_cast<u128>(v) -
+                                                 hi_bits));
+}
+
+// Payne-Hanek для любого конечного x: |x| = m * 2^e, m -- 53-битное целое.
+// Биты 2/pi до позиции e - 1 дают в m * 2^e * (2/pi) слагаемые, кратные 4,
+// и на квадрант не влияют, поэтому берётся только окно из 192 бит после
+// них. Ответ: x = q * pi/2 + r + dr, |r| <= pi/4, dr -- хвост r
+inline unsigned reduce_payne_hanek(double x, double& r, double& dr) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  int const exponent = static_cast<int>((bits >> 52) & 0x7ff);
+  std::uint64_t const m = (bits & ((std::uint64_t(1) << 52) - 1)) |
+                          (std::uint64_t(1) << 52);
+  int const e = exponent - 1075;
+
+  // окно с позиции e - 1; в таблице позиция i лежит в бите i + 63
+  int const k0 = e + 62;
+  int const word = k0 / 64;
+  int const shift = k0 % 64;
+  std::uint64_t w[3];
+  for (int j = 0; j < 3; ++j) {
+    w[j] = two_over_pi_bits[word + j] << shift;
+    if (shift) w[j] |= two_over_pi_bits[word + j + 1] >> (64 - shift);
+  }
+
+  // m * окно по модулю 2^192: два старших бита -- квадрант, остальное --
+  // дробная часть x * 2/pi
+  using u128 = unsigned __int128;
+  u128 const p2 = u128(m) * w[2];
+  u128 const p1 = u128(m) * w[1];
+  std::uint64_t const lo = static_cast<std::uint64_t>(p2);
+  u128 const mid_sum = (p2 >> 64) + static_cast<std::uint64_t>(p1);
+  std::uint64_t const mid = static_cast<std::uint64_t>(mid_sum);
+  std::uint64_t const hi = static_cast<std::uint64_t>(p1 >> 64) + m * w[0] +
+                           static_cast<std::uint64_t>(mid_sum >> 64);
+
+  // дробь как знаковое число в [-1/2, 1/2): отрицательная -- значит
+  // ближайшее целое на единицу больше
+  u128 const frac_bits = (u128((hi << 2) | (mid >> 62)) << 64) |
+                         ((mid << 2) | (lo >> 62));
+  __int128 const frac = static_cast<__int128>(frac_bits);
+  unsigned q = static_cast<unsigned>(hi >> 62) + (frac < 0);
+
+  // frac * 2^-128 как сумма двух double, затем умножение на pi/2
+  double f_hi, f_lo;
+  split_int128(frac, f_hi, f_lo);
+  double const a = f_hi * 0x1p-128;
+  double const b = f_lo * 0x1p-128;
+  double const p = a * pio2_hi;
+  double const t = std::fma(a, pio2_hi, -p) + (a * pio2_lo + b * pio2_hi);
+  r = p + t;
+  dr = t - (r - p);
+
+  if (x < 0) {
+    r = -r;
+    dr = -dr;
+    q = 4 - q;
+  }
+  return q & 3;
+}
+
+// приведение для любого x; для inf и nan r = nan
+inline unsigned reduce(double x, double& r, double& dr) {
+  dr = 0.0;
+  if (std::abs(x) <= cody_waite_limit) return reduce_cody_waite(x, r);
+  if (!std::isfinite(x)) {
+    r = x - x;
+    return 0;
+  }
+  return reduce_payne_hanek(x, r, dr);
+}
+
+// sin и cos от q * pi/2 + r + dr; поправка dr -- первый член Тейлора
+constexpr double sin_quadrant(unsigned q, double r, double dr) {
+  double v = (q & 1) ? cos_poly(r) - r * dr : sin_poly(r) + dr;
+  return (q & 2) ? -v : v;
+}
+
+constexpr double cos_quadrant(unsigned q, double r, double dr) {
+  double v = (q & 1) ? sin_poly(r) + dr : cos_poly(r) - r * dr;
+  return ((q + 1) & 2) ? -v : v;
+}
+
+// оба значения из одного приведения
+constexpr void sincos_quadrant(unsigned q, double r, double dr, double& s,
+                               double& c) {
+  double const sr = sin_poly(r) + dr;
+  double const cr = cos_poly(r) - r * dr;
+  s = (q & 1) ? cr : sr;
+  c = (q & 1) ? sr : cr;
+  if (q & 2) s = -s;
+  if ((q + 1) & 2) c = -c;
+}
+
+}  // namespace trig
+
+#endif
@@ -1,6 +1,79 @@
 #include "include/my_math.hpp"
+#include "include/stream_eval.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace {
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: MyMath\n"
+               "       MyMath --stream [--binary-in] [--binary-out] "
+               "[--threads N]\n"
+               "                       [--block-kb N] [input|- [output|-]]\n");
+}
+
+// вход и выход -- файлы или stdin/stdout ("-" или не указаны)
+int run_stream(int argc, char* argv[]) {
+  StreamOptions options;
+  const char* paths[2] = {"-", "-"};
+  int positional = 0;
+  for (int i = 2; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--binary-in") == 0) {
+      options.binary_in = true;
+    } else if (std::strcmp(argv[i], "--binary-out") == 0) {
+      options.binary_out = true;
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--block-kb") == 0 && i + 1 < argc) {
+      options.block_bytes = std::strtoull(argv[++i], nullptr, 10) << 10;
+    } else if (positional < 2 &&
+               (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0)) {
+      paths[positional++] = argv[i];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  bool const use_stdin = std::strcmp(paths[0], "-") == 0;
+  bool const use_stdout = std::strcmp(paths[1], "-") == 0;
+  std::FILE* in = use_stdin ? stdin : std::fopen(paths[0], "rb");
+  if (in == nullptr) {
+    std::perror(paths[0]);
+    return 1;
+  }
+  std::FILE* out = use_stdout ? stdout : std::fopen(paths[1], "wb");
+  if (out == nullptr) {
+    std::perror(paths[1]);
+    if (!use_stdin) std::fclose(in);
+    return 1;
+  }
+
+  int status = 0;
+  try {
+    stream_eval(in, out, options);
+  } catch (std::exception const& e) {
+    std::fprintf(stderr, "MyMath: %s\n", e.what());
+    status = 1;
+  }
+  if (!use_stdin) std::fclose(in);
+  if (!use_stdout && std::fclose(out) != 0) status = 1;
+  return status;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    if (std::strcmp(argv[1], "--stream") == 0) return run_stream(argc, argv);
+    usage();
+    return 1;
+  }
 
-int main() {
   double x = 1.0;
 
   AnswerHandler sin_result = my_sin(x);
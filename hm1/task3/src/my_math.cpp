@@ -2,54 +2,47 @@
 
 #include <cmath>
 
-AnswerHandler my_sin(double x) {
+#include "../include/trig_kernels.hpp"
+
+// x = q * pi/2 + r, |r| <= pi/4: Cody-Waite до 1e6, дальше Payne-Hanek,
+// затем многочлен фиксированной степени -- время не зависит от x
+TRIG_FMA_CLONES AnswerHandler my_sin(double x) {
   AnswerHandler result;
   result.x = x;
 
-  double sum = 0.0;
-  double term = x;
-  int n = 1;
-
-  while (std::abs(term) > 1e-10) {
-    sum += term;
-    term *= -x * x / ((2 * n) * (2 * n + 1));
-    n++;
-  }
-
-  result.result = sum;
+  double r, dr;
+  unsigned q = trig::reduce(x, r, dr);
+  result.result = trig::sin_quadrant(q, r, dr);
   return result;
 }
 
-AnswerHandler my_cos(double x) {
+TRIG_FMA_CLONES AnswerHandler my_cos(double x) {
   AnswerHandler result;
   result.x = x;
 
-  double sum = 0.0;
-  double term = 1.0;
-  int n = 1;
+  double r, dr;
+  unsigned q = trig::reduce(x, r, dr);
+  result.result = trig::cos_quadrant(q, r, dr);
+  return result;
+}
 
-  while (std::abs(term) > 1e-10) {
-    sum += term;
-    term *= -x * x / ((2 * n - 1) * (2 * n));
-    n++;
-  }
+TRIG_FMA_CLONES SinCos my_sincos(double x) {
+  SinCos result;
+  result.x = x;
 
-  result.result = sum;
+  double r, dr;
+  unsigned q = trig::reduce(x, r, dr);
+  trig::sincos_quadrant(q, r, dr, result.sin, result.cos);
   return result;
 }
 
-AnswerHandler my_tan(double x) {
+// tan = sin / cos из одного приведения; около pi/2 + k*pi просто большое
+// по модулю число, как у std::tan
+TRIG_FMA_CLONES AnswerHandler my_tan(double x) {
   AnswerHandler result;
   result.x = x;
 
-  AnswerHandler sin_result = my_sin(x);
-  AnswerHandler cos_result = my_cos(x);
-
-  if (std::abs(cos_result.result) < 1e-10) {
-    result.result = 0.0;
-  } else {
-    result.result = sin_result.result / cos_result.result;
-  }
-
+  SinCos sc = my_sincos(x);
+  result.result = sc.sin / sc.cos;
   return result;
 }
@@ -0,0 +1,282 @@
+#include "../include/my_math.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "../include/trig_kernels.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum class Func { sin, cos, tan, sincos };
+
+// полный скалярный путь, в том числе Payne-Hanek для больших |x|;
+// out2 нужен только sincos (туда идёт cos)
+template <Func F>
+void eval_scalar(double x, double* out, double* out2) {
+  double r, dr;
+  unsigned q = trig::reduce(x, r, dr);
+  if constexpr (F == Func::sin) {
+    *out = trig::sin_quadrant(q, r, dr);
+  } else if constexpr (F == Func::cos) {
+    *out = trig::cos_quadrant(q, r, dr);
+  } else {
+    double s, c;
+    trig::sincos_quadrant(q, r, dr, s, c);
+    if constexpr (F == Func::tan) {
+      *out = s / c;
+    } else {
+      *out = s;
+      *out2 = c;
+    }
+  }
+}
+
+template <Func F>
+TRIG_FMA_CLONES void batch_scalar(const double* in, double* out,
+                                  double* out2, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    eval_scalar<F>(in[i], out + i, F == Func::sincos ? out2 + i : nullptr);
+  }
+}
+
+#if defined(__x86_64__)
+
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+// 4 значения за раз; ветвлений по данным нет, квадрант выбирается масками
+template <Func F>
+TARGET_AVX2 void batch_avx2(const double* in, double* out, double* out2,
+                            std::size_t n) {
+  const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+  const __m256d limit = _mm256_set1_pd(trig::cody_waite_limit);
+  const __m256d inf = _mm256_set1_pd(INFINITY);
+  const __m256d magic = _mm256_set1_pd(trig::round_magic);
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i two = _mm256_set1_epi64x(2);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d x = _mm256_loadu_pd(in + i);
+    __m256d ax = _mm256_and_pd(x, abs_mask);
+    __m256d huge = _mm256_and_pd(_mm256_cmp_pd(ax, limit, _CMP_GT_OQ),
+                                 _mm256_cmp_pd(ax, inf, _CMP_LT_OQ));
+
+    __m256d k = _mm256_fmadd_pd(x, _mm256_set1_pd(trig::two_over_pi), magic);
+    __m256i q = _mm256_castpd_si256(k);
+    k = _mm256_sub_pd(k, magic);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(trig::pio2_1), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(trig::pio2_2), r);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(trig::pio2_3), r);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(trig::pio2_3t), r);
+
+    __m256d z = _mm256_mul_pd(r, r);
+    __m256d ps = _mm256_fmadd_pd(z, _mm256_set1_pd(trig::S6),
+                                 _mm256_set1_pd(trig::S5));
+    ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(trig::S4));
+    ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(trig::S3));
+    ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(trig::S2));
+    ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(trig::S1));
+    __m256d s = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+
+    __m256d pc = _mm256_fmadd_pd(z, _mm256_set1_pd(trig::C6),
+                                 _mm256_set1_pd(trig::C5));
+    pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(trig::C4));
+    pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(trig::C3));
+    pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(trig::C2));
+    pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(trig::C1));
+    __m256d c = _mm256_fmadd_pd(
+        _mm256_mul_pd(z, z), pc,
+        _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+    // нечётный квадрант меняет sin и cos местами
+    __m256d swap = _mm256_castsi256_pd(
+        _mm256_cmpeq_epi64(_mm256_and_si256(q, one), one));
+    __m256i sign_s = _mm256_slli_epi64(_mm256_and_si256(q, two), 62);
+    __m256i sign_c = _mm256_slli_epi64(
+        _mm256_and_si256(_mm256_add_epi64(q, one), two), 62);
+    __m256d sin_x = _mm256_xor_pd(_mm256_blendv_pd(s, c, swap),
+                                  _mm256_castsi256_pd(sign_s));
+    __m256d cos_x = _mm256_xor_pd(_mm256_blendv_pd(c, s, swap),
+                                  _mm256_castsi256_pd(sign_c));
+    if constexpr (F == Func::sin) {
+      _mm256_storeu_pd(out + i, sin_x);
+    } else if constexpr (F == Func::cos) {
+      _mm256_storeu_pd(out + i, cos_x);
+    } else if constexpr (F == Func::tan) {
+      _mm256_storeu_pd(out + i, _mm256_div_pd(sin_x, cos_x));
+    } else {
+      _mm256_storeu_pd(out + i, sin_x);
+      _mm256_storeu_pd(out2 + i, cos_x);
+    }
+
+    if (int lanes = _mm256_movemask_pd(huge)) {
+      alignas(32) double xs[4];
+      _mm256_store_pd(xs, x);
+      for (int j = 0; j < 4; ++j) {
+        if (!(lanes & (1 << j))) continue;
+        eval_scalar<F>(xs[j], out + i + j,
+                       F == Func::sincos ? out2 + i + j : nullptr);
+      }
+    }
+  }
+  batch_scalar<F>(in + i, out + i, F == Func::sincos ? out2 + i : nullptr,
+                  n - i);
+}
+
+// то же на 8 значениях; маски AVX-512 вместо blendv
+template <Func F>
+TARGET_AVX512 void batch_avx512(const double* in, double* out, double* out2,
+                                std::size_t n) {
+  const __m512d limit = _mm512_set1_pd(trig::cody_waite_limit);
+  const __m512d inf = _mm512_set1_pd(INFINITY);
+  const __m512d magic = _mm512_set1_pd(trig::round_magic);
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i two = _mm512_set1_epi64(2);
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d x = _mm512_loadu_pd(in + i);
+    __m512d ax = _mm512_abs_pd(x);
+    __mmask8 huge = _mm512_cmp_pd_mask(ax, limit, _CMP_GT_OQ) &
+                    _mm512_cmp_pd_mask(ax, inf, _CMP_LT_OQ);
+
+    __m512d k = _mm512_fmadd_pd(x, _mm512_set1_pd(trig::two_over_pi), magic);
+    __m512i q = _mm512_castpd_si512(k);
+    k = _mm512_sub_pd(k, magic);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(trig::pio2_1), x);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(trig::pio2_2), r);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(trig::pio2_3), r);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(trig::pio2_3t), r);
+
+    __m512d z = _mm512_mul_pd(r, r);
+    __m512d ps = _mm512_fmadd_pd(z, _mm512_set1_pd(trig::S6),
+                                 _mm512_set1_pd(trig::S5));
+    ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(trig::S4));
+    ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(trig::S3));
+    ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(trig::S2));
+    ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(trig::S1));
+    __m512d s = _mm512_fmadd_pd(_mm512_mul_pd(r, z), ps, r);
+
+    __m512d pc = _mm512_fmadd_pd(z, _mm512_set1_pd(trig::C6),
+                                 _mm512_set1_pd(trig::C5));
+    pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(trig::C4));
+    pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(trig::C3));
+    pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(trig::C2));
+    pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(trig::C1));
+    __m512d c = _mm512_fmadd_pd(
+        _mm512_mul_pd(z, z), pc,
+        _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+    __mmask8 swap = _mm512_test_epi64_mask(q, one);
+    // maskz, а не slli: slli берёт _mm512_undefined, и GCC 12 выдаёт ложное
+    // -Wmaybe-uninitialized
+    __m512i sign_s =
+        _mm512_maskz_slli_epi64(0xFF, _mm512_and_si512(q, two), 62);
+    __m512i sign_c = _mm512_maskz_slli_epi64(
+        0xFF, _mm512_and_si512(_mm512_add_epi64(q, one), two), 62);
+    __m512d sin_x = _mm512_castsi512_pd(_mm512_xor_si512(
+        _mm512_castpd_si512(_mm512_mask_blend_pd(swap, s, c)), sign_s));
+    __m512d cos_x = _mm512_castsi512_pd(_mm512_xor_si512(
+        _mm512_castpd_si512(_mm512_mask_blend_pd(swap, c, s)), sign_c));
+    if constexpr (F == Func::sin) {
+      _mm512_storeu_pd(out + i, sin_x);
+    } else if constexpr (F == Func::cos) {
+      _mm512_storeu_pd(out + i, cos_x);
+    } else if constexpr (F == Func::tan) {
+      _mm512_storeu_pd(out + i, _mm512_div_pd(sin_x, cos_x));
+    } else {
+      _mm512_storeu_pd(out + i, sin_x);
+      _mm512_storeu_pd(out2 + i, cos_x);
+    }
+
+    if (huge) {
+      alignas(64) double xs[8];
+      _mm512_store_pd(xs, x);
+      for (int j = 0; j < 8; ++j) {
+        if (!(huge & (1 << j))) continue;
+        eval_scalar<F>(xs[j], out + i + j,
+                       F == Func::sincos ? out2 + i + j : nullptr);
+      }
+    }
+  }
+  batch_scalar<F>(in + i, out + i, F == Func::sincos ? out2 + i : nullptr,
+                  n - i);
+}
+
+#endif
+
+using BatchFn = void (*)(const double*, double*, double*, std::size_t);
+
+enum class Isa { scalar, avx2, avx512 };
+
+Isa detect_isa() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return Isa::avx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Isa::avx2;
+  }
+#endif
+  return Isa::scalar;
+}
+
+Isa batch_isa() {
+  static const Isa isa = detect_isa();
+  return isa;
+}
+
+template <Func F>
+BatchFn select_kernel() {
+#if defined(__x86_64__)
+  switch (batch_isa()) {
+    case Isa::avx512:
+      return batch_avx512<F>;
+    case Isa::avx2:
+      return batch_avx2<F>;
+    case Isa::scalar:
+      break;
+  }
+#endif
+  return batch_scalar<F>;
+}
+
+}  // namespace
+
+void my_sin(const double* in, double* out, std::size_t n) {
+  static const BatchFn kernel = select_kernel<Func::sin>();
+  kernel(in, out, nullptr, n);
+}
+
+void my_cos(const double* in, double* out, std::size_t n) {
+  static const BatchFn kernel = select_kernel<Func::cos>();
+  kernel(in, out, nullptr, n);
+}
+
+void my_tan(const double* in, double* out, std::size_t n) {
+  static const BatchFn kernel = select_kernel<Func::tan>();
+  kernel(in, out, nullptr, n);
+}
+
+void my_sincos(const double* in, double* sin_out, double* cos_out,
+               std::size_t n) {
+  static const BatchFn kernel = select_kernel<Func::sincos>();
+  kernel(in, sin_out, cos_out, n);
+}
+
+const char* my_math_batch_isa() {
+  switch (batch_isa()) {
+    case Isa::avx512:
+      return "avx512";
+    case Isa::avx2:
+      return "avx2";
+    case Isa::scalar:
+      break;
+  }
+  return "scalar";
+}
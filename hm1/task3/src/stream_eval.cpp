@@ -0,0 +1,381 @@
+#include "../include/stream_eval.hpp"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/my_math.hpp"
+
+namespace {
+
+// самая длинная кратчайшая запись double: -1.2345678901234567e-308
+constexpr std::size_t max_number_chars = 24;
+constexpr std::size_t max_line_chars = 4 * (max_number_chars + 1);
+// обычная строка короче: "1 0.8414709848078965 0.5403023058681398 ..."
+constexpr std::size_t typical_line_chars = 64;
+constexpr std::size_t min_block_bytes = 4096;
+
+// буфер без обнуления при росте: блоки переиспользуются, и в устоявшемся
+// режиме память не выделяется вовсе
+template <typename T>
+class Buffer {
+  std::unique_ptr<T[]> data_;
+  std::size_t capacity_ = 0;
+
+ public:
+  T* reserve(std::size_t n) {
+    if (n > capacity_) {
+      data_.reset(new T[n]);
+      capacity_ = n;
+    }
+    return data_.get();
+  }
+
+  // как reserve, но первые keep элементов сохраняются
+  T* grow(std::size_t n, std::size_t keep) {
+    if (n > capacity_) {
+      std::unique_ptr<T[]> fresh(new T[n]);
+      std::copy(data_.get(), data_.get() + keep, fresh.get());
+      data_ = std::move(fresh);
+      capacity_ = n;
+    }
+    return data_.get();
+  }
+
+  T* data() const { return data_.get(); }
+};
+
+// результаты -- структурой массивов, чтобы пакетные ядра шли подряд
+struct Block {
+  std::size_t seq = 0;
+  Buffer<char> input;
+  std::size_t input_size = 0;
+  Buffer<double> x, sin, cos, tan;
+  Buffer<char> output;
+  std::size_t output_size = 0;
+};
+
+template <typename T>
+class BlockingQueue {
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<T> items_;
+  bool closed_ = false;
+
+ public:
+  void push(T value) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      items_.push_back(std::move(value));
+    }
+    ready_.notify_one();
+  }
+
+  // false -- очередь закрыта и пуста
+  bool pop(T& value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    if (items_.empty()) return false;
+    value = std::move(items_.front());
+    items_.pop_front();
+    return true;
+  }
+
+  // discard -- при ошибке: оставшееся больше никому не выдаётся
+  void close(bool discard = false) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      if (discard) items_.clear();
+    }
+    ready_.notify_all();
+  }
+};
+
+// готовые блоки приходят от рабочих в любом порядке, выдаются по seq
+class Reorder {
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::map<std::size_t, Block*> items_;
+  std::size_t next_ = 0;
+  bool closed_ = false;
+
+ public:
+  void push(Block* block) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      items_.emplace(block->seq, block);
+    }
+    ready_.notify_one();
+  }
+
+  bool pop(Block*& block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [&] {
+      return closed_ || (!items_.empty() && items_.begin()->first == next_);
+    });
+    if (items_.empty() || items_.begin()->first != next_) return false;
+    block = items_.begin()->second;
+    items_.erase(items_.begin());
+    ++next_;
+    return true;
+  }
+
+  void close(bool discard = false) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      if (discard) items_.clear();
+    }
+    ready_.notify_all();
+  }
+};
+
+bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+[[noreturn]] void bad_number(const char* first, const char* last) {
+  const char* end = first;
+  while (end != last && !is_space(*end) && end - first < 32) ++end;
+  throw std::runtime_error("bad number: '" + std::string(first, end) + "'");
+}
+
+// числа блока в out; '+' перед числом допускается, как в from_string, но
+// не перед знаком: "+-1" -- ошибка. out растёт по мере разбора, начальная
+// оценка -- число на 16 байт входа
+std::size_t parse_text(const char* p, const char* last, Buffer<double>& out) {
+  std::size_t capacity = static_cast<std::size_t>(last - p) / 16 + 16;
+  double* x = out.reserve(capacity);
+  std::size_t n = 0;
+  while (true) {
+    while (p != last && is_space(*p)) ++p;
+    if (p == last) return n;
+    if (n == capacity) {
+      capacity *= 2;
+      x = out.grow(capacity, n);
+    }
+    const char* const token = p;
+    if (last - p > 1 && *p == '+' && p[1] != '-') ++p;
+    auto const [end, ec] = std::from_chars(p, last, x[n]);
+    if (ec != std::errc{} || (end != last && !is_space(*end))) {
+      bad_number(token, last);
+    }
+    p = end;
+    ++n;
+  }
+}
+
+class Pipeline {
+  std::FILE* in_;
+  std::FILE* out_;
+  StreamOptions options_;
+  std::vector<Block> blocks_;
+  BlockingQueue<Block*> free_;
+  BlockingQueue<Block*> work_;
+  Reorder done_;
+  std::atomic<unsigned> active_workers_{0};
+  std::atomic<bool> stopped_{false};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+
+ public:
+  Pipeline(std::FILE* in, std::FILE* out, StreamOptions const& options,
+           unsigned workers)
+      : in_(in), out_(out), options_(options), blocks_(2 * workers + 2) {
+    options_.block_bytes = std::max(options_.block_bytes, min_block_bytes);
+    for (Block& block : blocks_) free_.push(&block);
+  }
+
+  // рабочие в своих потоках, чтение -- в отдельном, запись -- в вызывающем
+  void run(unsigned workers) {
+    std::vector<std::thread> threads;
+    threads.reserve(workers + 1);
+    active_workers_ = workers;
+    try {
+      threads.emplace_back(&Pipeline::guard, this, &Pipeline::read);
+      for (unsigned i = 0; i < workers; ++i) {
+        threads.emplace_back(&Pipeline::guard, this, &Pipeline::work);
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+    guard(&Pipeline::write);
+    for (auto& thread : threads) thread.join();
+    if (error_) std::rethrow_exception(error_);
+  }
+
+ private:
+  void guard(void (Pipeline::*stage)()) {
+    try {
+      (this->*stage)();
+    } catch (...) {
+      fail(std::current_exception());
+    }
+  }
+
+  // первая ошибка останавливает все стадии
+  void fail(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (!error_) error_ = error;
+    }
+    stopped_ = true;
+    free_.close(true);
+    work_.close(true);
+    done_.close(true);
+  }
+
+  // блок обрезается по последнему пробельному символу (текст) или по
+  // границе double (двоичный вход); хвост переносится в следующий блок
+  void read() {
+    std::size_t const size = options_.block_bytes;
+    std::vector<char> carry;
+    std::size_t seq = 0;
+    bool eof = false;
+    Block* block = nullptr;
+    while (!eof && free_.pop(block)) {
+      char* const data = block->input.reserve(size);
+      std::copy(carry.begin(), carry.end(), data);
+      std::size_t const wanted = size - carry.size();
+      std::size_t got = 0;
+      eof = !fill(data + carry.size(), wanted, got);
+      if (stopped_) break;
+      std::size_t const have = carry.size() + got;
+
+      std::size_t keep = have;
+      if (options_.binary_in) {
+        keep = have - have % sizeof(double);
+        if (eof && keep != have) {
+          throw std::runtime_error("truncated binary input");
+        }
+      } else if (!eof) {
+        while (keep != 0 && !is_space(data[keep - 1])) --keep;
+        if (keep == 0) throw std::runtime_error("token longer than block");
+      }
+      carry.assign(data + keep, data + have);
+
+      block->input_size = keep;
+      block->seq = seq++;
+      work_.push(block);
+    }
+    work_.close();
+  }
+
+  // читает, пока не наберёт wanted байт; false -- конец входа. Ожидание --
+  // через poll с таймаутом: если другая стадия упала, чтение из канала,
+  // в который больше не пишут, не держит конвейер
+  bool fill(char* data, std::size_t wanted, std::size_t& got) {
+    int const fd = fileno(in_);
+    while (got < wanted && !stopped_) {
+      pollfd ready{fd, POLLIN, 0};
+      int const events = poll(&ready, 1, 100);
+      if (events == 0 || (events < 0 && errno == EINTR)) continue;
+      if (events < 0) throw std::runtime_error("read failed");
+      ssize_t const n = ::read(fd, data + got, wanted - got);
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) throw std::runtime_error("read failed");
+      if (n == 0) return false;
+      got += static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  void work() {
+    Block* block = nullptr;
+    while (work_.pop(block)) {
+      compute(*block);
+      done_.push(block);
+    }
+    if (--active_workers_ == 0) done_.close();
+  }
+
+  void compute(Block& block) {
+    const char* const input = block.input.data();
+    std::size_t n = 0;
+    if (options_.binary_in) {
+      n = block.input_size / sizeof(double);
+      std::memcpy(block.x.reserve(n), input, n * sizeof(double));
+    } else {
+      n = parse_text(input, input + block.input_size, block.x);
+    }
+
+    double const* const x = block.x.data();
+    double* const s = block.sin.reserve(n);
+    double* const c = block.cos.reserve(n);
+    double* const t = block.tan.reserve(n);
+    my_sincos(x, s, c, n);
+    // my_tan считает так же, но повторил бы приведение аргумента
+    for (std::size_t i = 0; i < n; ++i) t[i] = s[i] / c[i];
+
+    if (options_.binary_out) {
+      char* out = block.output.reserve(n * 4 * sizeof(double));
+      for (std::size_t i = 0; i < n; ++i) {
+        double const record[4] = {x[i], s[i], c[i], t[i]};
+        std::memcpy(out, record, sizeof(record));
+        out += sizeof(record);
+      }
+      block.output_size = n * 4 * sizeof(double);
+      return;
+    }
+
+    // буфер -- по обычной длине строки и растёт по мере надобности: запас
+    // на худший случай для плотного входа в десятки раз больше самого блока
+    std::size_t capacity = n * typical_line_chars + max_line_chars;
+    char* first = block.output.reserve(capacity);
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if (capacity - size < max_line_chars) {
+        capacity *= 2;
+        first = block.output.grow(capacity, size);
+      }
+      char* out = first + size;
+      for (double v : {x[i], s[i], c[i], t[i]}) {
+        out = std::to_chars(out, first + capacity, v).ptr;
+        *out++ = ' ';
+      }
+      out[-1] = '\n';
+      size = static_cast<std::size_t>(out - first);
+    }
+    block.output_size = size;
+  }
+
+  void write() {
+    Block* block = nullptr;
+    while (done_.pop(block)) {
+      std::size_t const size = block->output_size;
+      if (size != 0 &&
+          std::fwrite(block->output.data(), 1, size, out_) != size) {
+        throw std::runtime_error("write failed");
+      }
+      free_.push(block);
+    }
+    if (std::fflush(out_) != 0) throw std::runtime_error("write failed");
+  }
+};
+
+}  // namespace
+
+void stream_eval(std::FILE* in, std::FILE* out,
+                 StreamOptions const& options) {
+  unsigned workers = options.threads;
+  if (workers == 0) workers = std::thread::hardware_concurrency();
+  if (workers == 0) workers = 1;
+  Pipeline(in, out, options, workers).run(workers);
+}
@@ -0,0 +1,285 @@
+#include "../include/my_math.hpp"
+#include "../include/stream_eval.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// одинаковые биты; все nan считаются равными
+bool same(double a, double b) {
+  if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+std::vector<double> sample(std::size_t n) {
+  std::mt19937_64 gen(7);
+  std::uniform_real_distribution<double> small(-10, 10);
+  std::uniform_real_distribution<double> medium(-1e6, 1e6);
+  std::uniform_real_distribution<double> order(6, 300);
+  std::vector<double> xs;
+  for (std::size_t i = 0; i < n; ++i) {
+    switch (i % 3) {
+      case 0:
+        xs.push_back(small(gen));
+        break;
+      case 1:
+        xs.push_back(medium(gen));
+        break;
+      default:
+        xs.push_back(std::pow(10.0, order(gen)) * ((i & 1) ? -1 : 1));
+    }
+  }
+  double const inf = std::numeric_limits<double>::infinity();
+  double const nan = std::numeric_limits<double>::quiet_NaN();
+  for (double x : {0.0, -0.0, 1e-300, -5e-324, 1e6, -1e6,
+                   std::nextafter(1e6, 2e6), inf, -inf, nan,
+                   std::numeric_limits<double>::max()}) {
+    xs.push_back(x);
+  }
+  return xs;
+}
+
+// пакет и скалярные функции дают одни и те же биты, где бы x ни оказался:
+// в векторной дорожке, в хвосте или в дорожке с Payne-Hanek
+void test_batch_matches_scalar() {
+  std::vector<double> const xs = sample(100003);
+  std::size_t const n = xs.size();
+  std::vector<double> s(n), c(n), t(n), s2(n), c2(n);
+  for (std::size_t offset : {0, 3}) {
+    std::size_t const m = n - offset;
+    my_sin(xs.data() + offset, s.data(), m);
+    my_cos(xs.data() + offset, c.data(), m);
+    my_tan(xs.data() + offset, t.data(), m);
+    my_sincos(xs.data() + offset, s2.data(), c2.data(), m);
+    for (std::size_t i = 0; i < m; ++i) {
+      double const x = xs[offset + i];
+      SinCos const sc = my_sincos(x);
+      assert(same(s[i], my_sin(x).result));
+      assert(same(c[i], my_cos(x).result));
+      assert(same(t[i], my_tan(x).result));
+      assert(same(s2[i], sc.sin));
+      assert(same(c2[i], sc.cos));
+      assert(same(sc.sin, s[i]) && same(sc.cos, c[i]));
+    }
+  }
+}
+
+// дробь около 1/2 (r около pi/4) округляется до 2^127 -- вне __int128
+void test_split_int128() {
+  __int128 const max = ~(static_cast<__int128>(1) << 127);
+  double hi, lo;
+  trig::split_int128(max, hi, lo);
+  assert(hi == 0x1p127 && lo == -1.0);
+  trig::split_int128(-max - 1, hi, lo);
+  assert(hi == -0x1p127 && lo == 0.0);
+  __int128 const v = -(static_cast<__int128>(0x1fffffffffffffll) << 60) - 7;
+  trig::split_int128(v, hi, lo);
+  assert(static_cast<__int128>(hi) == v + 7 && lo == -7.0);
+}
+
+// ошибка табличных уровней одна и та же при любом |x|
+template <Accuracy A>
+void test_tier(double bound) {
+  for (double x : sample(30000)) {
+    if (!std::isfinite(x)) {
+      assert(std::isnan(my_sin<A>(x)) && std::isnan(my_cos<A>(x)));
+      continue;
+    }
+    assert(std::abs(my_sin<A>(x) - sinl(x)) < bound);
+    assert(std::abs(my_cos<A>(x) - cosl(x)) < bound);
+  }
+}
+
+// ошибка в ulp относительно long double; ref -- эталон sinl/cosl/tanl
+double ulps(double got, long double ref) {
+  double const rounded = static_cast<double>(ref);
+  double const ulp = std::nextafter(std::abs(rounded),
+                                    std::numeric_limits<double>::infinity()) -
+                     std::abs(rounded);
+  return static_cast<double>(std::abs(got - ref) / ulp);
+}
+
+// полная точность на каждом пути приведения: без приведения (|x| <= pi/4),
+// Cody-Waite (до 1e6) и Payne-Hanek (дальше)
+void test_full_accuracy() {
+  std::mt19937_64 gen(11);
+  std::uniform_real_distribution<double> small(-0.785, 0.785);
+  std::uniform_real_distribution<double> medium(-1e6, 1e6);
+  std::uniform_real_distribution<double> order(6, 300);
+  double worst = 0;
+  for (int i = 0; i < 30000; ++i) {
+    double x;
+    switch (i % 3) {
+      case 0:
+        x = small(gen);
+        break;
+      case 1:
+        x = medium(gen);
+        break;
+      default:
+        x = std::pow(10.0, order(gen)) * ((i & 1) ? -1 : 1);
+    }
+    long double const s = sinl(x);
+    long double const c = cosl(x);
+    worst = std::max(worst, ulps(my_sin(x).result, s));
+    worst = std::max(worst, ulps(my_cos(x).result, c));
+    // у полюсов tan обусловлен плохо, ошибка приведения там растёт
+    if (std::abs(c) > 1e-3L) {
+      worst = std::max(worst, ulps(my_tan(x).result, tanl(x)));
+    }
+  }
+  assert(worst < 4);
+  for (double x : {0.0, 1e-300, 0.785, 1e6, 1e22, 1e300}) {
+    assert(ulps(my_sin<Accuracy::full>(x), sinl(x)) < 4);
+    assert(ulps(my_cos<Accuracy::full>(x), cosl(x)) < 4);
+  }
+}
+
+// табличные уровни по-прежнему считаются при компиляции
+constexpr double sin_1e6 = -0.34999350217129294;
+static_assert(my_sin<Accuracy::taylor3>(1e6) - sin_1e6 < 4e-12 &&
+              my_sin<Accuracy::taylor3>(1e6) - sin_1e6 > -4e-12);
+
+std::string run_stream(std::string const& input, StreamOptions const& opt) {
+  std::FILE* in = std::tmpfile();
+  std::FILE* out = std::tmpfile();
+  std::fwrite(input.data(), 1, input.size(), in);
+  std::rewind(in);
+  std::string result;
+  try {
+    stream_eval(in, out, opt);
+    std::rewind(out);
+    char buf[4096];
+    while (std::size_t n = std::fread(buf, 1, sizeof(buf), out)) {
+      result.append(buf, n);
+    }
+  } catch (...) {
+    std::fclose(in);
+    std::fclose(out);
+    throw;
+  }
+  std::fclose(in);
+  std::fclose(out);
+  return result;
+}
+
+bool stream_fails(std::string const& input, StreamOptions const& opt) {
+  try {
+    run_stream(input, opt);
+  } catch (std::runtime_error const&) {
+    return true;
+  }
+  return false;
+}
+
+// маленькие блоки и несколько рабочих: порядок и биты -- как у my_sin и т.д.
+void test_stream() {
+  std::vector<double> const xs = sample(20000);
+  std::string text, binary;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    char buf[32];
+    char* end = std::to_chars(buf, buf + sizeof(buf), xs[i]).ptr;
+    if (i % 5 == 0 && xs[i] >= 0) text += '+';
+    text.append(buf, end);
+    text += (i % 3 == 0) ? "\n" : " \t";
+    binary.append(reinterpret_cast<const char*>(&xs[i]), sizeof(double));
+  }
+
+  StreamOptions opt;
+  opt.threads = 3;
+  opt.block_bytes = 4096;
+  std::string const lines = run_stream(text, opt);
+  opt.binary_in = opt.binary_out = true;
+  std::string const records = run_stream(binary, opt);
+  assert(records.size() == xs.size() * 4 * sizeof(double));
+
+  const char* p = lines.data();
+  const char* const last = p + lines.size();
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    double const expected[4] = {xs[i], my_sin(xs[i]).result,
+                                my_cos(xs[i]).result, my_tan(xs[i]).result};
+    double record[4];
+    std::memcpy(record, records.data() + i * sizeof(record), sizeof(record));
+    for (int k = 0; k < 4; ++k) {
+      double v;
+      auto const [end, ec] = std::from_chars(p, last, v);
+      assert(ec == std::errc{} && *end == (k == 3 ? '\n' : ' '));
+      p = end + 1;
+      assert(same(v, expected[k]) && same(record[k], expected[k]));
+    }
+  }
+  assert(p == last);
+
+  // плотный вход: буферы чисел и строк растут с начальной оценки
+  std::string dense;
+  std::string expected_dense;
+  std::string const line = run_stream("1", StreamOptions{});
+  for (int i = 0; i < 20000; ++i) {
+    dense += "1\n";
+    expected_dense += line;
+  }
+  opt.binary_in = opt.binary_out = false;
+  assert(run_stream(dense, opt) == expected_dense);
+
+  StreamOptions const text_opt;
+  assert(run_stream("", text_opt).empty());
+  assert(run_stream(" +0 ", text_opt) == "0 0 1 0\n");
+  assert(stream_fails("1 +-1", text_opt));
+  assert(stream_fails("1 ++1", text_opt));
+  assert(stream_fails("1 2.5-3", text_opt));
+  assert(stream_fails("+", text_opt));
+  StreamOptions binary_opt;
+  binary_opt.binary_in = true;
+  assert(stream_fails("0123456789", binary_opt));
+}
+
+// запись упала, а в канал на входе больше не пишут и не закрывают его:
+// stream_eval всё равно возвращается
+void test_stream_write_failure() {
+  int fds[2];
+  assert(pipe(fds) == 0);
+  std::string numbers;
+  while (numbers.size() < 3 * 4096) numbers += "1 ";
+  assert(write(fds[1], numbers.data(), numbers.size()) ==
+         static_cast<ssize_t>(numbers.size()));
+  std::FILE* in = fdopen(fds[0], "r");
+  std::FILE* out = std::fopen("/dev/full", "w");
+  assert(in != nullptr && out != nullptr);
+  StreamOptions opt;
+  opt.block_bytes = 4096;
+  bool failed = false;
+  try {
+    stream_eval(in, out, opt);
+  } catch (std::runtime_error const&) {
+    failed = true;
+  }
+  assert(failed);
+  std::fclose(in);
+  std::fclose(out);
+  close(fds[1]);
+}
+
+}  // namespace
+
+int main() {
+  test_batch_matches_scalar();
+  test_split_int128();
+  test_full_accuracy();
+  test_tier<Accuracy::taylor3>(4e-12);
+  test_tier<Accuracy::linear>(5e-6);
+  test_stream();
+  test_stream_write_failure();
+  return 0;
+}
@@ -1,8 +1,10 @@
-template <typename T>
+#include <cstddef>
+
+template <typename T, typename I = std::size_t>
 class Grid final {
  public:
   using value_type = T;
-  using size_type = unsigned;
+  using size_type = I;
 
  private:
   T* const data;
@@ -11,10 +13,10 @@ class Grid final {
   Grid(T* data, size_type y_size, size_type x_size)
       : data(data), y_size(y_size), x_size(x_size) {}
 
-  Grid(Grid<T> const&) = delete;
-  Grid(Grid<T>&&) = delete;
-  Grid<T>& operator=(Grid<T> const&) = delete;
-  Grid<T>& operator=(Grid<T>&&) = delete;
+  Grid(Grid const&) = delete;
+  Grid(Grid&&) = delete;
+  Grid& operator=(Grid const&) = delete;
+  Grid& operator=(Grid&&) = delete;
 
  public:
   T operator()(size_type y_idx, size_type x_idx) const {
@@ -25,7 +27,7 @@ class Grid final {
     return data[y_idx * x_size + x_idx];
   }
 
-  Grid<T>& operator=(T const& t) {
+  Grid& operator=(T const& t) {
     for (auto it = data, end = data + x_size * y_size; it != end; ++it) *it = t;
     return *this;
   }
@@ -1,128 +1,9 @@
-#include <cassert>
-#include <new>
-
-template <typename T>
-class Grid final {
- public:
-  using value_type = T;
-  using size_type = unsigned;
-
- private:
-  T *data;
-  size_type y_size, x_size;
-
-  Grid(T *data, size_type y_size, size_type x_size)
-      : data(data), y_size(y_size), x_size(x_size) {}
-
-  // task 1:
-  void clear() {
-    if (data) {
-      for (size_type i = 0; i < y_size * x_size; ++i) {
-        data[i].~T();
-      }
-      ::operator delete(data);  // ыффективность
-      data = nullptr;
-    }
-  }
-
- public:
-  Grid(T const &t) : y_size(1), x_size(1) {
-    data = static_cast<T *>(::operator new(sizeof(T)));
-    new (data) T(t);
-  }
-
-  Grid(size_type y_size, size_type x_size) : y_size(y_size), x_size(x_size) {
-    data = static_cast<T *>(::operator new(sizeof(T) * y_size * x_size));
-    for (size_type i = 0; i < y_size * x_size; ++i) {
-      new (data + i) T();
-    }
-  }
-
-  Grid(size_type y_size, size_type x_size, T const &t)
-      : y_size(y_size), x_size(x_size) {
-    data = static_cast<T *>(::operator new(sizeof(T) * y_size * x_size));
-    for (size_type i = 0; i < y_size * x_size; ++i) {
-      new (data + i) T(t);
-    }
-  }
-
-  ~Grid() { clear(); }
-
-  Grid(Grid<T> const &other) : y_size(other.y_size), x_size(other.x_size) {
-    data = static_cast<T *>(::operator new(sizeof(T) * y_size * x_size));
-    for (size_type i = 0; i < y_size * x_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-  }
-
-  Grid(Grid<T> &&other) noexcept  // ыффективность
-      : data(other.data), y_size(other.y_size), x_size(other.x_size) {
-    other.data = nullptr;
-    other.y_size = 0;
-    other.x_size = 0;
-  }
+#include "include/grid2d.hpp"
 
-  Grid<T> &operator=(Grid<T> const &other) {
-    if (this == &other) return *this;
-    clear();
-    y_size = other.y_size;
-    x_size = other.x_size;
-    data = static_cast<T *>(::operator new(sizeof(T) * y_size * x_size));
-    for (size_type i = 0; i < y_size * x_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-    return *this;
-  }
-
-  Grid<T> &operator=(Grid<T> &&other) noexcept {
-    if (this == &other) return *this;
-    clear();
-    data = other.data;
-    y_size = other.y_size;
-    x_size = other.x_size;
-    other.data = nullptr;
-    other.y_size = 0;
-    other.x_size = 0;
-    return *this;
-  }
-
-  // task 2:
-  class RowProxy {
-    T *row_data;
-    size_type x_size;
-
-   public:
-    RowProxy(T *row_data, size_type x_size)
-        : row_data(row_data), x_size(x_size) {}
-
-    T &operator[](size_type x_idx) { return row_data[x_idx]; }
-    T operator[](size_type x_idx) const { return row_data[x_idx]; }
-  };
-
-  RowProxy operator[](size_type y_idx) {
-    return RowProxy(data + y_idx * x_size, x_size);
-  }
-  RowProxy operator[](size_type y_idx) const {
-    return RowProxy(data + y_idx * x_size, x_size);
-  }
-
-  // base:
-  T operator()(size_type y_idx, size_type x_idx) const {
-    return data[y_idx * x_size + x_idx];
-  }
-
-  T &operator()(size_type y_idx, size_type x_idx) {
-    return data[y_idx * x_size + x_idx];
-  }
-
-  Grid<T> &operator=(T const &t) {
-    for (auto it = data, end = data + x_size * y_size; it != end; ++it) *it = t;
-    return *this;
-  }
-
-  size_type get_y_size() const { return y_size; }
-  size_type get_x_size() const { return x_size; }
-};
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <type_traits>
 
 int main() {
   Grid<float> g(3, 2, 0.0f);
@@ -143,5 +24,17 @@ int main() {
     for (gsize_t x_idx = 0; x_idx != g.get_x_size(); ++x_idx)
       assert(1.0f == g(y_idx, x_idx));
 
+  std::transform(g.begin(), g.end(), g.begin(), [](float v) { return v * 2; });
+  assert(2.0f == std::accumulate(g[2].begin(), g[2].end(), 0.0f) / 2);
+  assert(g.data() + g.size() == g.end());
+
+  // строка константной сетки не даёт менять элементы
+  Grid<float> const& cg = g;
+  static_assert(std::is_same_v<decltype(cg[0].begin()), float const*>);
+  static_assert(!std::is_assignable_v<decltype(cg[0][0]), float>);
+  static_assert(std::is_same_v<decltype(g[0].begin()), float*>);
+  assert(&cg[1][1] == &g(1, 1) && 2 == cg[2].size());
+  assert(2.0f == *std::max_element(cg[0].begin(), cg[0].end()));
+
   return 0;
 }
@@ -1,226 +1,35 @@
-#include <cassert>
-#include <new>
-
-template <typename T, unsigned D>
-class Grid {
- public:
-  using value_type = T;
-  using size_type = unsigned;
-
-  template <typename TT, unsigned DD>
-  friend class Grid;
-
- private:
-  T* data;
-  size_type dims[D];
-  size_type total_size;
-
-  size_type get_index(size_type const* indices) const {
-    auto index = indices[0];
-    for (size_type i = 1; i < D; ++i) {
-      index = index * dims[i] + indices[i];
-    }
-    return index;
-  }
+#include "include/grid.hpp"
+#include "include/grid_io.hpp"
 
-  void clear() {
-    if (data) {
-      for (size_type i = 0; i < total_size; ++i) {
-        data[i].~T();
-      }
-      ::operator delete(data);
-      data = nullptr;
-    }
-  }
-
- public:
-  template <typename... Args>
-  Grid(Args... args) {
-    size_type temp[] = {static_cast<size_type>(args)...};
-    for (size_type i = 0; i < D; ++i) {
-      dims[i] = temp[i];
-    }
-    total_size = 1;
-    for (size_type i = 0; i < D; ++i) {
-      total_size *= dims[i];
-    }
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    if constexpr (sizeof...(Args) == D) {
-      for (size_type i = 0; i < total_size; ++i) {
-        new (data + i) T();
-      }
-    } else if constexpr (sizeof...(Args) == D + 1) {
-      T fill_value = static_cast<T>(temp[D]);
-      for (size_type i = 0; i < total_size; ++i) {
-        new (data + i) T(fill_value);
-      }
-    }
-  }
-
-  Grid() : data(nullptr), dims{}, total_size(0) {}
-
-  ~Grid() { clear(); }
-
-  Grid(Grid const& other) : total_size(other.total_size) {
-    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-  }
-
-  Grid(Grid&& other) noexcept : data(other.data), total_size(other.total_size) {
-    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
-    other.data = nullptr;
-    other.total_size = 0;
-    for (size_type i = 0; i < D; ++i) other.dims[i] = 0;
-  }
-
-  Grid& operator=(Grid const& other) {
-    if (this == &other) return *this;
-    clear();
-    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
-    total_size = other.total_size;
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-    return *this;
-  }
-
-  Grid& operator=(Grid&& other) noexcept {
-    if (this == &other) return *this;
-    clear();
-    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
-    data = other.data;
-    total_size = other.total_size;
-    other.data = nullptr;
-    other.total_size = 0;
-    for (size_type i = 0; i < D; ++i) other.dims[i] = 0;
-    return *this;
-  }
-
-  template <typename... Args>
-  T operator()(Args... args) const {
-    size_type indices[] = {static_cast<size_type>(args)...};
-    return data[get_index(indices)];
-  }
-
-  template <typename... Args>
-  T& operator()(Args... args) {
-    size_type indices[] = {static_cast<size_type>(args)...};
-    return data[get_index(indices)];
-  }
-
-  Grid<T, D - 1> operator[](size_type idx) { return slice(idx); }
-
-  Grid<T, D - 1> operator[](size_type idx) const { return slice(idx); }
-
- private:
-  Grid<T, D - 1> slice(size_type idx) const {
-    size_type slice_size = 1;
-    for (size_type i = 1; i < D; ++i) slice_size *= dims[i];
-    size_type offset = idx * slice_size;
-    Grid<T, D - 1> result;
-    for (size_type i = 0; i < D - 1; ++i) result.dims[i] = dims[i + 1];
-    result.total_size = slice_size;
-    result.data = static_cast<T*>(::operator new(sizeof(T) * slice_size));
-    for (size_type i = 0; i < slice_size; ++i) {
-      new (result.data + i) T(data[offset + i]);
-    }
-    return result;
-  }
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// копия бросает, когда copies_left доходит до нуля; live -- живые объекты
+struct Fragile {
+  static int live;
+  static int copies_left;
+
+  Fragile() { ++live; }
+  Fragile(Fragile const&) {
+    if (copies_left-- == 0) throw std::runtime_error("copy failed");
+    ++live;
+  }
+  ~Fragile() { --live; }
 };
 
-template <typename T>
-class Grid<T, 1> {
- public:
-  using value_type = T;
-  using size_type = unsigned;
+int Fragile::live = 0;
+int Fragile::copies_left = -1;
 
-  template <typename TT, unsigned DD>
-  friend class Grid;
-
- private:
-  T* data;
-  size_type dims[1];
-  size_type total_size;
-
-  void clear() {
-    if (data) {
-      for (size_type i = 0; i < total_size; ++i) {
-        data[i].~T();
-      }
-      ::operator delete(data);
-      data = nullptr;
-    }
-  }
-
- public:
-  Grid() : data(nullptr), dims{0}, total_size(0) {}
-
-  Grid(size_type size) : dims{size}, total_size(size) {
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T();
-    }
-  }
-
-  Grid(size_type size, T const& t) : dims{size}, total_size(size) {
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T(t);
-    }
-  }
-
-  ~Grid() { clear(); }
-
-  Grid(Grid const& other) : dims{other.dims[0]}, total_size(other.total_size) {
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-  }
-
-  Grid(Grid&& other) noexcept
-      : data(other.data), dims{other.dims[0]}, total_size(other.total_size) {
-    other.data = nullptr;
-    other.total_size = 0;
-    other.dims[0] = 0;
-  }
-
-  Grid& operator=(Grid const& other) {
-    if (this == &other) return *this;
-    clear();
-    dims[0] = other.dims[0];
-    total_size = other.total_size;
-    data = static_cast<T*>(::operator new(sizeof(T) * total_size));
-    for (size_type i = 0; i < total_size; ++i) {
-      new (data + i) T(other.data[i]);
-    }
-    return *this;
-  }
-
-  Grid& operator=(Grid&& other) noexcept {
-    if (this == &other) return *this;
-    clear();
-    data = other.data;
-    dims[0] = other.dims[0];
-    total_size = other.total_size;
-    other.data = nullptr;
-    other.total_size = 0;
-    other.dims[0] = 0;
-    return *this;
-  }
-
-  T operator()(size_type idx) const { return data[idx]; }
-
-  T& operator()(size_type idx) { return data[idx]; }
-
-  T& operator[](size_type idx) { return data[idx]; }
-
-  T operator[](size_type idx) const { return data[idx]; }
-};
+}  // namespace
 
 int main() {
   Grid<float, 3> const g3(2, 3, 4, 1.0f);
@@ -232,5 +41,179 @@ int main() {
   g2 = g3[1];
   assert(1.0f == g2(1, 1));
 
+  constexpr StaticGrid<int, Extents<2, 3>> s2(7);
+  static_assert(7 == s2(1, 2));
+  static_assert(sizeof(s2) == 6 * sizeof(int));
+
+  StaticGrid<float, Extents<3, dynamic, 4>> sd(5, 1.0f);
+  assert(5 == sd.extent<1>());
+  assert(1.0f == sd(2, 4, 3));
+  static_assert(sizeof(sd) == sizeof(float*) + sizeof(std::size_t));
+
+  bool overflow = false;
+  try {
+    Grid<char, 3, unsigned> huge(1u << 16, 1u << 16, 2);
+  } catch (std::length_error const&) {
+    overflow = true;
+  }
+  assert(overflow);
+
+  Grid<double, 3> big(parallel, 64, 64, 64, 0.5);
+  Grid<double, 3> big_copy(parallel_t{3}, big);
+  big_copy.fill(parallel, 2.5);
+  auto const all_equal = [](auto const& grid, auto value) {
+    return std::all_of(grid.begin(), grid.end(),
+                       [&](auto const& v) { return v == value; });
+  };
+  assert(all_equal(big, 0.5) && all_equal(big_copy, 2.5));
+
+  // каждый индекс ровно в одном куске, даже когда n не делится на число
+  // потоков или потоков больше, чем элементов
+  for (unsigned threads : {1u, 3u, 4u, 8u}) {
+    for (std::size_t n : {0, 1, 5, 91, 1000}) {
+      std::vector<int> hits(n);
+      parallel_for(parallel_t{threads}, n,
+                   [&](std::size_t begin, std::size_t end) {
+                     for (std::size_t i = begin; i < end; ++i) ++hits[i];
+                   });
+      assert(std::all_of(hits.begin(), hits.end(),
+                         [](int h) { return h == 1; }));
+    }
+    Grid<int, 2> odd(parallel_t{threads}, 7, 13, 3);
+    assert(all_equal(odd, 3));
+    odd.fill(parallel_t{threads}, -1);
+    Grid<int, 2> odd_copy(parallel_t{threads}, odd);
+    assert(all_equal(odd, -1) && all_equal(odd_copy, -1));
+
+    Grid<int, 1> line(parallel_t{threads}, 91, 7);
+    Grid<int, 1> line_copy(parallel_t{threads}, line);
+    line.fill(parallel_t{threads}, 4);
+    assert(all_equal(line, 4) && all_equal(line_copy, 7));
+    std::vector<int> owner(line.size(), -1);
+    int part = 0;
+    line.for_each_partition(parallel_t{threads}, [&](int* first, int* last) {
+      static std::mutex guard;
+      std::lock_guard<std::mutex> lock(guard);
+      for (int* p = first; p != last; ++p) owner[p - line.data()] = part;
+      ++part;
+    });
+    assert(std::none_of(owner.begin(), owner.end(),
+                        [](int o) { return o < 0; }));
+  }
+  Grid<double, 1> line(parallel, 1000);
+  assert(all_equal(line, 0.0) && 1000 == line.extent(0));
+
+  Grid<int, 3> cube(40, 50, 60);
+  std::iota(cube.begin(), cube.end(), 0);
+  for (auto const& idx : cube.indices()) {
+    auto const expected = (idx[0] * 50 + idx[1]) * 60 + idx[2];
+    assert(cube(idx[0], idx[1], idx[2]) == static_cast<int>(expected));
+  }
+  assert(60 == cube.row(3, 4).size() && cube(3, 4, 0) == cube.row(3, 4)[0]);
+  assert(cube.plane(1).begin() == cube.row(1, 0).begin());
+  auto shuffled = cube.view().permuted({2, 0, 1}).reversed(0).materialize();
+  for (int x = 0; x < 60; ++x)
+    for (int z = 0; z < 40; ++z)
+      for (int y = 0; y < 50; ++y)
+        assert(shuffled(59 - x, z, y) == cube(z, y, x));
+  auto const& ccube = cube;
+  assert(ccube.view().transposed()(59, 49, 39) == cube(39, 49, 59));
+
+  // материализация, упавшая на середине блока, в начале или в конце,
+  // разрушает всё, что успела построить
+  {
+    Grid<Fragile, 3> source(30, 40, 50);
+    for (int fail_at : {0, 7, 1234, 33333, 59999}) {
+      Fragile::copies_left = fail_at;
+      bool thrown = false;
+      try {
+        source.view().permuted({1, 2, 0}).reversed(2).materialize();
+      } catch (std::runtime_error const&) {
+        thrown = true;
+      }
+      assert(thrown && 60000 == Fragile::live);
+    }
+    Fragile::copies_left = -1;
+    auto const copy = source.view().transposed().materialize();
+    assert(120000 == Fragile::live && 30 == copy.extent(2));
+  }
+  assert(0 == Fragile::live);
+
+  std::stringstream stream;
+  write_grid(stream, cube, GridCodec::rle, 8);
+  auto restored = read_grid<int, 3>(stream);
+  assert(std::equal(cube.begin(), cube.end(), restored.begin()));
+  stream.clear();
+  stream.seekg(0);
+  GridReader<int, 3> reader(stream);
+  std::vector<int> chunk;
+  assert(8 == reader.read_chunk(4, chunk) && chunk[0] == cube(32, 0, 0));
+
+  // сетка посреди потока: смещения чанков -- от её начала
+  std::stringstream framed;
+  framed << "prefix before the grid\n";
+  auto const grid_start = framed.tellp();
+  Grid<int, 3, unsigned> small(11, 3, 5);
+  std::iota(small.begin(), small.end(), 100);
+  write_grid(framed, small, GridCodec::none, 4);
+  write_grid(framed, cube, GridCodec::rle, 8);
+  framed << "trailing data";
+  framed.seekg(grid_start);
+  GridReader<int, 3, unsigned> first(framed);
+  assert(3 == first.chunks());
+  assert(3 == first.read_chunk(2, chunk) && chunk[0] == small(8, 0, 0));
+  assert(4 == first.read_chunk(0, chunk) && chunk[0] == 100);
+  framed.seekg(grid_start);
+  auto const read_back = read_grid<int, 3, unsigned>(framed);
+  assert(std::equal(small.begin(), small.end(), read_back.begin()));
+  auto const second_start = framed.tellg();
+  GridReader<int, 3> second(framed);
+  for (std::size_t c : {4, 0, 2}) {
+    second.read_chunk(c, chunk);
+    assert(chunk[0] == cube(c * 8, 0, 0) &&
+           chunk.back() == cube(c * 8 + 7, 49, 59));
+  }
+  framed.seekg(second_start);
+  auto const second_back = read_grid<int, 3>(framed);
+  assert(std::equal(cube.begin(), cube.end(), second_back.begin()));
+  std::string rest;
+  std::getline(framed, rest);
+  assert("trailing data" == rest);
+
+  std::stringstream packed;
+  write_grid(packed, big, GridCodec::rle);
+  assert(packed.str().size() < big.size() * sizeof(double) / 100);
+  assert(0.5 == (read_grid<double, 3>(packed)(5, 6, 7)));
+
+  Grid<float, 2> series(0, 4);
+  for (int step = 0; step < 100; ++step) {
+    float const sample[] = {1.0f * step, 2.0f, 3.0f, 4.0f};
+    series.append_row(sample);
+  }
+  assert(100 == series.extent(0) && series.capacity() >= 100);
+  assert(99.0f == series(99, 0) && 4.0f == series(50, 3));
+  assert(series(7, 2) == series.reshape(50, 8)(3, 6));
+  float const* const storage = series.data();
+  auto flat = std::move(series).reshape(400);
+  assert(flat.data() == storage && 99.0f == flat(396));
+
+  SparseGrid<int, 3> sp(1000, 1000, 1000, -1);
+  assert(-1 == std::as_const(sp)(999, 5, 7));
+  sp(999, 5, 7) = 3;
+  assert(1 == sp.block_count() && 1000000000 == sp.size());
+  int occupied = 0;
+  sp.for_each([&](auto const& idx, int value) {
+    occupied += value != -1;
+    assert(value == -1 || (idx[0] == 999 && idx[1] == 5 && idx[2] == 7));
+  });
+  assert(1 == occupied);
+  bool sparse_overflow = false;
+  try {
+    SparseGrid<int, 3, 8, unsigned> too_big(1u << 16, 1u << 16, 2);
+  } catch (std::length_error const&) {
+    sparse_overflow = true;
+  }
+  assert(sparse_overflow);
+
   return 0;
 }
@@ -0,0 +1,100 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// одна строка CSV на измерение:
+// benchmark,type,rank,elements,bytes,ns,gb_per_s,elements_per_ns
+// ns -- время одной операции (проход по сетке, копия, move),
+// bytes -- объём элементов сетки, которую она обрабатывает
+class Bench {
+ public:
+  Bench(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--max-bytes") == 0 && i + 1 < argc) {
+        max_bytes = std::strtoull(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+        min_time_ns = std::strtod(argv[++i], nullptr) * 1e6;
+      }
+    }
+    std::printf(
+        "benchmark,type,rank,elements,bytes,ns,gb_per_s,elements_per_ns\n");
+  }
+
+  // от L1 (16 KiB) до DRAM (256 MiB по умолчанию), шаг x16
+  template <typename F>
+  void for_each_size(F&& f) const {
+    for (std::size_t bytes = 16 * 1024; bytes <= max_bytes; bytes *= 16) {
+      f(bytes);
+    }
+  }
+
+  // лучшее время из нескольких повторов, каждый не короче min_time_ns
+  template <typename F>
+  double measure(F&& f) const {
+    using clock = std::chrono::steady_clock;
+    f();
+    std::size_t iterations = 1;
+    double best = 0;
+    for (int repeat = 0; repeat < 5; ++repeat) {
+      while (true) {
+        auto const start = clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) f();
+        double const elapsed =
+            std::chrono::duration<double, std::nano>(clock::now() - start)
+                .count();
+        if (elapsed >= min_time_ns || iterations >= (std::size_t(1) << 30)) {
+          double const per_call = elapsed / static_cast<double>(iterations);
+          best = repeat == 0 ? per_call : std::min(best, per_call);
+          break;
+        }
+        iterations *= 2;
+      }
+    }
+    return best;
+  }
+
+  void report(std::string const& name, char const* type, unsigned rank,
+              std::size_t elements, std::size_t bytes, double ns) const {
+    std::printf("%s,%s,%u,%zu,%zu,%.3f,%.3f,%.4f\n", name.c_str(), type, rank,
+                elements, bytes, ns, static_cast<double>(bytes) / ns,
+                static_cast<double>(elements) / ns);
+    std::fflush(stdout);
+  }
+
+ private:
+  std::size_t max_bytes = std::size_t(256) << 20;
+  double min_time_ns = 20e6;
+};
+
+// не даёт компилятору выбросить вычисленное значение
+template <typename T>
+void keep(T const& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+char const* type_name();
+
+template <>
+inline char const* type_name<float>() {
+  return "float";
+}
+
+template <>
+inline char const* type_name<double>() {
+  return "double";
+}
+
+template <>
+inline char const* type_name<unsigned char>() {
+  return "uint8";
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "../include/grid2d.hpp"
+#include "bench.hpp"
+
+#include <cmath>
+
+template <typename T>
+void run_type(Bench const& bench) {
+  bench.for_each_size([&](std::size_t bytes) {
+    auto const side = static_cast<std::size_t>(
+        std::sqrt(static_cast<double>(bytes / sizeof(T))));
+    std::size_t const elements = side * side;
+    Grid<T> g(side, side, T(1));
+
+    auto report = [&](char const* name, double ns) {
+      bench.report(name, type_name<T>(), 2, elements, elements * sizeof(T),
+                   ns);
+    };
+
+    report("operator()(y,x)", bench.measure([&] {
+      T acc{};
+      for (std::size_t y = 0; y != side; ++y)
+        for (std::size_t x = 0; x != side; ++x) acc += g(y, x);
+      keep(acc);
+    }));
+
+    report("RowProxy[y][x]", bench.measure([&] {
+      T acc{};
+      for (std::size_t y = 0; y != side; ++y)
+        for (std::size_t x = 0; x != side; ++x) acc += g[y][x];
+      keep(acc);
+    }));
+
+    report("copy_construct", bench.measure([&] {
+      Grid<T> copy(g);
+      keep(&copy);
+    }));
+
+    report("move_construct_assign", bench.measure([&] {
+      Grid<T> moved(std::move(g));
+      g = std::move(moved);
+      keep(&g);
+    }));
+  });
+}
+
+int main(int argc, char* argv[]) {
+  Bench bench(argc, argv);
+  run_type<unsigned char>(bench);
+  run_type<float>(bench);
+  run_type<double>(bench);
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "../include/grid.hpp"
+#include "bench.hpp"
+
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+template <unsigned D>
+std::array<std::size_t, D> cube_dims(std::size_t elements) {
+  auto const side = std::max<long long>(
+      1, std::llround(std::pow(static_cast<double>(elements), 1.0 / D)));
+  std::array<std::size_t, D> dims;
+  dims.fill(static_cast<std::size_t>(side));
+  return dims;
+}
+
+template <typename T, unsigned D, std::size_t... Is>
+Grid<T, D> make_grid(std::array<std::size_t, D> const& dims,
+                     std::index_sequence<Is...>) {
+  return Grid<T, D>(dims[Is]..., T(1));
+}
+
+// полный проход через operator(), то есть через get_index
+template <typename T, unsigned D, typename... Idx>
+void sum_all(Grid<T, D> const& g, std::size_t const* dims, T& acc,
+             Idx... idx) {
+  if constexpr (sizeof...(Idx) == D) {
+    acc += g(idx...);
+  } else {
+    for (std::size_t i = 0; i != dims[sizeof...(Idx)]; ++i) {
+      sum_all(g, dims, acc, idx..., i);
+    }
+  }
+}
+
+template <typename T, unsigned D>
+void run_rank(Bench const& bench, std::size_t bytes) {
+  auto const dims = cube_dims<D>(bytes / sizeof(T));
+  std::size_t elements = 1;
+  for (auto dim : dims) elements *= dim;
+  std::size_t const grid_bytes = elements * sizeof(T);
+  auto g = make_grid<T, D>(dims, std::make_index_sequence<D>{});
+  Grid<T, D> const& cg = g;
+
+  auto report = [&](char const* name, double ns) {
+    bench.report(name, type_name<T>(), D, elements, grid_bytes, ns);
+  };
+
+  report("operator()", bench.measure([&] {
+    T acc{};
+    sum_all(cg, dims.data(), acc);
+    keep(acc);
+  }));
+
+  if constexpr (D >= 2) {
+    report("operator[]_slice", bench.measure([&] {
+      for (std::size_t i = 0; i != dims[0]; ++i) {
+        auto slice = cg[i];
+        keep(&slice);
+      }
+    }));
+    report("transpose_materialize", bench.measure([&] {
+      auto transposed = cg.view().transposed().materialize();
+      keep(&transposed);
+    }));
+  }
+
+  if constexpr (D == 3) {
+    report("begin_end_accumulate", bench.measure([&] {
+      keep(std::accumulate(cg.begin(), cg.end(), T{}));
+    }));
+    report("copy_construct", bench.measure([&] {
+      Grid<T, D> copy(cg);
+      keep(&copy);
+    }));
+    report("move_construct_assign", bench.measure([&] {
+      Grid<T, D> moved(std::move(g));
+      g = std::move(moved);
+      keep(&g);
+    }));
+    report("fill_serial", bench.measure([&] {
+      g = T(2);
+      keep(&g);
+    }));
+    report("fill_parallel", bench.measure([&] {
+      g.fill(parallel, T(3));
+      keep(&g);
+    }));
+  }
+}
+
+template <typename T>
+void run_type(Bench const& bench) {
+  bench.for_each_size([&](std::size_t bytes) {
+    run_rank<T, 1>(bench, bytes);
+    run_rank<T, 2>(bench, bytes);
+    run_rank<T, 3>(bench, bytes);
+    run_rank<T, 4>(bench, bytes);
+  });
+}
+
+int main(int argc, char* argv[]) {
+  Bench bench(argc, argv);
+  run_type<unsigned char>(bench);
+  run_type<float>(bench);
+  run_type<double>(bench);
+  return 0;
+}
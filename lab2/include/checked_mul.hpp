@@ -0,0 +1,18 @@
+#ifndef CHECKED_MUL_HPP
+#define CHECKED_MUL_HPP
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// произведение размеров; переполнение -- std::length_error
+template <typename I>
+constexpr I checked_mul(I a, I b) {
+  static_assert(std::is_unsigned_v<I>, "index type must be unsigned");
+  if (b != 0 && a > std::numeric_limits<I>::max() / b) {
+    throw std::length_error("grid size overflow");
+  }
+  return a * b;
+}
+
+#endif
@@ -0,0 +1,1256 @@
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "checked_mul.hpp"
+
+// число потоков для параллельной инициализации; 0 -- по числу ядер
+struct parallel_t {
+  unsigned threads = 0;
+
+  unsigned count() const {
+    if (threads != 0) return threads;
+    unsigned const hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+  }
+};
+
+inline constexpr parallel_t parallel{};
+
+// статическое разбиение [0, n): кусок part всегда достаётся одному и тому же
+// потоку, поэтому страницы касается тот же поток, что и в вычислениях потом
+template <typename I>
+std::pair<I, I> static_partition(I n, unsigned parts, unsigned part) {
+  I const chunk = n / parts;
+  I const extra = n % parts;
+  I const begin = part * chunk + std::min<I>(part, extra);
+  return {begin, begin + chunk + (part < extra ? 1 : 0)};
+}
+
+// f(begin, end) для каждого куска; поток 0 -- вызывающий
+template <typename I, typename F>
+void parallel_for(parallel_t par, I n, F const& f) {
+  unsigned const parts = par.count();
+  auto run = [&](unsigned part) {
+    auto const [begin, end] = static_partition(n, parts, part);
+    f(begin, end);
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(parts - 1);
+  for (unsigned part = 1; part < parts; ++part) {
+    try {
+      pool.emplace_back(run, part);
+    } catch (std::system_error const&) {
+      run(part);
+    }
+  }
+  run(0);
+  for (auto& thread : pool) thread.join();
+}
+
+// непрерывный кусок памяти сетки; указатели -- обычные contiguous-итераторы
+template <typename T>
+class Range {
+  T* first;
+  T* last;
+
+ public:
+  Range(T* first, T* last) : first(first), last(last) {}
+
+  T* begin() const { return first; }
+  T* end() const { return last; }
+  T* data() const { return first; }
+  std::size_t size() const { return static_cast<std::size_t>(last - first); }
+  T& operator[](std::size_t idx) const { return first[idx]; }
+};
+
+// обход всех мультииндексов сетки в порядке хранения
+template <unsigned D, typename I>
+class IndexRange {
+ public:
+  using index_type = std::array<I, D>;
+
+  class iterator {
+    index_type idx;
+    index_type const* dims;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = index_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = index_type const*;
+    using reference = index_type const&;
+
+    iterator(index_type idx, index_type const* dims) : idx(idx), dims(dims) {}
+
+    reference operator*() const { return idx; }
+    pointer operator->() const { return &idx; }
+
+    iterator& operator++() {
+      for (unsigned axis = D; axis-- > 1;) {
+        if (++idx[axis] < (*dims)[axis]) return *this;
+        idx[axis] = 0;
+      }
+      ++idx[0];
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(iterator const& other) const { return idx == other.idx; }
+    bool operator!=(iterator const& other) const { return idx != other.idx; }
+  };
+
+ private:
+  index_type dims;
+
+ public:
+  explicit IndexRange(I const* grid_dims) {
+    for (unsigned i = 0; i < D; ++i) dims[i] = grid_dims[i];
+  }
+
+  iterator begin() const {
+    for (auto dim : dims) {
+      if (dim == 0) return end();
+    }
+    return iterator(index_type{}, &dims);
+  }
+
+  iterator end() const {
+    index_type idx{};
+    idx[0] = dims[0];
+    return iterator(idx, &dims);
+  }
+};
+
+// переносит n элементов в новую память и разрушает старые; если перенос
+// бросил, уже перенесённые копии разрушаются, а исходные остаются целыми
+template <typename T, typename I>
+void relocate(T* from, I n, T* to) {
+  I i = 0;
+  try {
+    for (; i < n; ++i) new (to + i) T(std::move_if_noexcept(from[i]));
+  } catch (...) {
+    while (i-- > 0) to[i].~T();
+    throw;
+  }
+  for (i = 0; i < n; ++i) from[i].~T();
+}
+
+// память под n элементов без конструирования; общая для Grid и StaticGrid
+template <typename T>
+T* allocate_elements(std::size_t n) {
+  return static_cast<T*>(
+      ::operator new(checked_mul<std::size_t>(sizeof(T), n)));
+}
+
+// разрушает n элементов и освобождает память, data обнуляется
+template <typename T, typename I>
+void destroy_elements(T*& data, I n) {
+  if (!data) return;
+  for (I i = 0; i < n; ++i) data[i].~T();
+  ::operator delete(data);
+  data = nullptr;
+}
+
+// смещение мультииндекса в порядке хранения (последняя ось -- подряд)
+template <typename I>
+constexpr I row_major_offset(I const* extents, I const* indices,
+                             unsigned rank) {
+  I offset = indices[0];
+  for (unsigned i = 1; i < rank; ++i) {
+    offset = offset * extents[i] + indices[i];
+  }
+  return offset;
+}
+
+template <typename T, unsigned D, typename I>
+class GridView;
+
+template <typename T, unsigned D, typename I = std::size_t>
+class Grid {
+ public:
+  using value_type = T;
+  using size_type = I;
+
+  template <typename TT, unsigned DD, typename II>
+  friend class Grid;
+
+  template <typename TT, unsigned DD, typename II>
+  friend class GridView;
+
+ private:
+  T* data_;
+  size_type dims[D];
+  size_type total_size;
+  size_type capacity_;
+
+  size_type get_index(size_type const* indices) const {
+    return row_major_offset(dims, indices, D);
+  }
+
+  static T* allocate(size_type n) { return allocate_elements<T>(n); }
+
+  template <typename Tuple, std::size_t... Is>
+  void set_dims(Tuple const& tuple, std::index_sequence<Is...>) {
+    ((dims[Is] = static_cast<size_type>(std::get<Is>(tuple))), ...);
+  }
+
+  void clear() { destroy_elements(data_, total_size); }
+
+  void grow(size_type elements) {
+    T* fresh = allocate(elements);
+    try {
+      relocate(data_, total_size, fresh);
+    } catch (...) {
+      ::operator delete(fresh);
+      throw;
+    }
+    ::operator delete(data_);
+    data_ = fresh;
+    capacity_ = elements;
+  }
+
+  void check_reshape(size_type const* new_dims, unsigned rank) const {
+    size_type product = 1;
+    for (unsigned i = 0; i < rank; ++i) {
+      product = checked_mul(product, new_dims[i]);
+    }
+    if (product != total_size) {
+      throw std::invalid_argument("reshape must keep the element count");
+    }
+  }
+
+ public:
+  template <typename... Args>
+  Grid(Args... args) : Grid(parallel_t{1}, args...) {}
+
+  // элементы конструируются параллельно тем же разбиением, что и в
+  // parallel_for; для бросающих конструкторов T -- последовательно
+  template <typename... Args>
+  Grid(parallel_t par, Args... args) {
+    static_assert(sizeof...(Args) == D || sizeof...(Args) == D + 1,
+                  "expected D extents and an optional fill value");
+    auto const tuple = std::make_tuple(args...);
+    total_size = 1;
+    set_dims(tuple, std::make_index_sequence<D>{});
+    for (size_type i = 0; i < D; ++i) {
+      total_size = checked_mul(total_size, dims[i]);
+    }
+    data_ = allocate(total_size);
+    capacity_ = total_size;
+    if constexpr (sizeof...(Args) == D) {
+      if (!std::is_nothrow_default_constructible_v<T>) par.threads = 1;
+      parallel_for(par, total_size, [this](size_type begin, size_type end) {
+        for (size_type i = begin; i < end; ++i) {
+          new (data_ + i) T();
+        }
+      });
+    } else {
+      T const fill_value = static_cast<T>(std::get<D>(tuple));
+      if (!std::is_nothrow_copy_constructible_v<T>) par.threads = 1;
+      parallel_for(par, total_size, [&](size_type begin, size_type end) {
+        for (size_type i = begin; i < end; ++i) {
+          new (data_ + i) T(fill_value);
+        }
+      });
+    }
+  }
+
+  Grid() : data_(nullptr), dims{}, total_size(0), capacity_(0) {}
+
+  ~Grid() { clear(); }
+
+  Grid(Grid const& other) : Grid(parallel_t{1}, other) {}
+
+  Grid(parallel_t par, Grid const& other)
+      : total_size(other.total_size), capacity_(other.total_size) {
+    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
+    data_ = allocate(total_size);
+    if (!std::is_nothrow_copy_constructible_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) {
+        new (data_ + i) T(other.data_[i]);
+      }
+    });
+  }
+
+  Grid(Grid&& other) noexcept
+      : data_(other.data_),
+        total_size(other.total_size),
+        capacity_(other.capacity_) {
+    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
+    other.data_ = nullptr;
+    other.total_size = 0;
+    other.capacity_ = 0;
+    for (size_type i = 0; i < D; ++i) other.dims[i] = 0;
+  }
+
+  Grid& operator=(Grid const& other) {
+    if (this == &other) return *this;
+    clear();
+    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
+    total_size = other.total_size;
+    capacity_ = total_size;
+    data_ = allocate(total_size);
+    for (size_type i = 0; i < total_size; ++i) {
+      new (data_ + i) T(other.data_[i]);
+    }
+    return *this;
+  }
+
+  Grid& operator=(Grid&& other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    for (size_type i = 0; i < D; ++i) dims[i] = other.dims[i];
+    data_ = other.data_;
+    total_size = other.total_size;
+    capacity_ = other.capacity_;
+    other.data_ = nullptr;
+    other.total_size = 0;
+    other.capacity_ = 0;
+    for (size_type i = 0; i < D; ++i) other.dims[i] = 0;
+    return *this;
+  }
+
+  Grid& operator=(T const& t) { return fill(parallel_t{1}, t); }
+
+  Grid& fill(parallel_t par, T const& t) {
+    if (!std::is_nothrow_copy_assignable_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) data_[i] = t;
+    });
+    return *this;
+  }
+
+  // то же разбиение, что при параллельной инициализации: f(first, last)
+  template <typename F>
+  void for_each_partition(parallel_t par, F const& f) {
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      f(data_ + begin, data_ + end);
+    });
+  }
+
+  template <typename... Args>
+  T operator()(Args... args) const {
+    size_type indices[] = {static_cast<size_type>(args)...};
+    return data_[get_index(indices)];
+  }
+
+  template <typename... Args>
+  T& operator()(Args... args) {
+    size_type indices[] = {static_cast<size_type>(args)...};
+    return data_[get_index(indices)];
+  }
+
+  T* data() { return data_; }
+  T const* data() const { return data_; }
+
+  T* begin() { return data_; }
+  T* end() { return data_ + total_size; }
+  T const* begin() const { return data_; }
+  T const* end() const { return data_ + total_size; }
+
+  size_type size() const { return total_size; }
+  size_type extent(unsigned axis) const { return dims[axis]; }
+
+  // число элементов в одном слое по первой оси
+  size_type slab_size() const {
+    size_type result = 1;
+    for (unsigned i = 1; i < D; ++i) result *= dims[i];
+    return result;
+  }
+
+  // ёмкость в слоях по первой оси
+  size_type capacity() const {
+    size_type const slab = slab_size();
+    return slab != 0 ? capacity_ / slab : dims[0];
+  }
+
+  void reserve(size_type slabs) {
+    size_type const elements = checked_mul(slabs, slab_size());
+    if (elements > capacity_) grow(elements);
+  }
+
+  // дописывает слой в конец первой оси за амортизированное O(slab):
+  // ёмкость растёт вдвое; slab не должен указывать в эту же сетку
+  void push_slab(T const* slab) {
+    size_type const n = slab_size();
+    if (capacity_ - total_size < n) {
+      reserve(std::max<size_type>(checked_mul<size_type>(dims[0], 2), 1));
+    }
+    size_type i = 0;
+    try {
+      for (; i < n; ++i) new (data_ + total_size + i) T(slab[i]);
+    } catch (...) {
+      while (i-- > 0) data_[total_size + i].~T();
+      throw;
+    }
+    total_size += n;
+    ++dims[0];
+  }
+
+  void append_row(T const* row) {
+    static_assert(D == 2, "append_row is for 2-D grids, use push_slab");
+    push_slab(row);
+  }
+
+  // та же память под другими экстентами за O(1); число элементов не меняется
+  template <typename... Args>
+  GridView<T, sizeof...(Args), I> reshape(Args... args) & {
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, sizeof...(Args));
+    return GridView<T, sizeof...(Args), I>(data_, new_dims);
+  }
+
+  template <typename... Args>
+  GridView<T const, sizeof...(Args), I> reshape(Args... args) const& {
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, sizeof...(Args));
+    return GridView<T const, sizeof...(Args), I>(data_, new_dims);
+  }
+
+  // у временной сетки буфер забирается в сетку новой формы без копирования
+  template <typename... Args>
+  Grid<T, sizeof...(Args), I> reshape(Args... args) && {
+    constexpr unsigned DD = sizeof...(Args);
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, DD);
+    Grid<T, DD, I> result;
+    for (unsigned i = 0; i < DD; ++i) result.dims[i] = new_dims[i];
+    result.data_ = std::exchange(data_, nullptr);
+    result.total_size = std::exchange(total_size, 0);
+    result.capacity_ = std::exchange(capacity_, 0);
+    for (unsigned i = 0; i < D; ++i) dims[i] = 0;
+    return result;
+  }
+
+  // срез по первой оси без копирования, в отличие от operator[]
+  Range<T> plane(size_type idx) {
+    size_type const plane_size = slab_size();
+    return Range<T>(data_ + idx * plane_size, data_ + (idx + 1) * plane_size);
+  }
+
+  Range<T const> plane(size_type idx) const {
+    size_type const plane_size = slab_size();
+    return Range<T const>(data_ + idx * plane_size,
+                          data_ + (idx + 1) * plane_size);
+  }
+
+  // строка вдоль последней оси, заданная D - 1 ведущими индексами
+  template <typename... Args>
+  Range<T> row(Args... args) {
+    static_assert(sizeof...(Args) == D - 1, "expected D - 1 indices");
+    size_type indices[] = {static_cast<size_type>(args)..., 0};
+    T* first = data_ + get_index(indices);
+    return Range<T>(first, first + dims[D - 1]);
+  }
+
+  template <typename... Args>
+  Range<T const> row(Args... args) const {
+    static_assert(sizeof...(Args) == D - 1, "expected D - 1 indices");
+    size_type indices[] = {static_cast<size_type>(args)..., 0};
+    T const* first = data_ + get_index(indices);
+    return Range<T const>(first, first + dims[D - 1]);
+  }
+
+  IndexRange<D, I> indices() const { return IndexRange<D, I>(dims); }
+
+  Grid<T, D - 1, I> operator[](size_type idx) { return slice(idx); }
+
+  Grid<T, D - 1, I> operator[](size_type idx) const { return slice(idx); }
+
+  GridView<T, D, I> view() { return GridView<T, D, I>(data_, dims); }
+
+  GridView<T const, D, I> view() const {
+    return GridView<T const, D, I>(data_, dims);
+  }
+
+ private:
+  Grid<T, D - 1, I> slice(size_type idx) const {
+    size_type slice_size = 1;
+    for (size_type i = 1; i < D; ++i) slice_size *= dims[i];
+    size_type offset = idx * slice_size;
+    Grid<T, D - 1, I> result;
+    for (size_type i = 0; i < D - 1; ++i) result.dims[i] = dims[i + 1];
+    result.total_size = slice_size;
+    result.capacity_ = slice_size;
+    result.data_ = allocate(slice_size);
+    for (size_type i = 0; i < slice_size; ++i) {
+      new (result.data_ + i) T(data_[offset + i]);
+    }
+    return result;
+  }
+};
+
+template <typename T, typename I>
+class Grid<T, 1, I> {
+ public:
+  using value_type = T;
+  using size_type = I;
+
+  template <typename TT, unsigned DD, typename II>
+  friend class Grid;
+
+  template <typename TT, unsigned DD, typename II>
+  friend class GridView;
+
+ private:
+  T* data_;
+  size_type dims[1];
+  size_type total_size;
+  size_type capacity_;
+
+  static T* allocate(size_type n) { return allocate_elements<T>(n); }
+
+  void clear() { destroy_elements(data_, total_size); }
+
+  void grow(size_type elements) {
+    T* fresh = allocate(elements);
+    try {
+      relocate(data_, total_size, fresh);
+    } catch (...) {
+      ::operator delete(fresh);
+      throw;
+    }
+    ::operator delete(data_);
+    data_ = fresh;
+    capacity_ = elements;
+  }
+
+  void check_reshape(size_type const* new_dims, unsigned rank) const {
+    size_type product = 1;
+    for (unsigned i = 0; i < rank; ++i) {
+      product = checked_mul(product, new_dims[i]);
+    }
+    if (product != total_size) {
+      throw std::invalid_argument("reshape must keep the element count");
+    }
+  }
+
+ public:
+  Grid() : data_(nullptr), dims{0}, total_size(0), capacity_(0) {}
+
+  Grid(size_type size) : Grid(parallel_t{1}, size) {}
+
+  Grid(size_type size, T const& t) : Grid(parallel_t{1}, size, t) {}
+
+  // та же параллельная первая запись, что и в общем случае
+  Grid(parallel_t par, size_type size)
+      : dims{size}, total_size(size), capacity_(size) {
+    data_ = allocate(total_size);
+    if (!std::is_nothrow_default_constructible_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [this](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) {
+        new (data_ + i) T();
+      }
+    });
+  }
+
+  Grid(parallel_t par, size_type size, T const& t)
+      : dims{size}, total_size(size), capacity_(size) {
+    data_ = allocate(total_size);
+    if (!std::is_nothrow_copy_constructible_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) {
+        new (data_ + i) T(t);
+      }
+    });
+  }
+
+  ~Grid() { clear(); }
+
+  Grid(Grid const& other) : Grid(parallel_t{1}, other) {}
+
+  Grid(parallel_t par, Grid const& other)
+      : dims{other.dims[0]},
+        total_size(other.total_size),
+        capacity_(other.total_size) {
+    data_ = allocate(total_size);
+    if (!std::is_nothrow_copy_constructible_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) {
+        new (data_ + i) T(other.data_[i]);
+      }
+    });
+  }
+
+  Grid(Grid&& other) noexcept
+      : data_(other.data_),
+        dims{other.dims[0]},
+        total_size(other.total_size),
+        capacity_(other.capacity_) {
+    other.data_ = nullptr;
+    other.total_size = 0;
+    other.capacity_ = 0;
+    other.dims[0] = 0;
+  }
+
+  Grid& operator=(Grid const& other) {
+    if (this == &other) return *this;
+    clear();
+    dims[0] = other.dims[0];
+    total_size = other.total_size;
+    capacity_ = total_size;
+    data_ = allocate(total_size);
+    for (size_type i = 0; i < total_size; ++i) {
+      new (data_ + i) T(other.data_[i]);
+    }
+    return *this;
+  }
+
+  Grid& operator=(Grid&& other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    data_ = other.data_;
+    dims[0] = other.dims[0];
+    total_size = other.total_size;
+    capacity_ = other.capacity_;
+    other.data_ = nullptr;
+    other.total_size = 0;
+    other.capacity_ = 0;
+    other.dims[0] = 0;
+    return *this;
+  }
+
+  Grid& operator=(T const& t) { return fill(parallel_t{1}, t); }
+
+  Grid& fill(parallel_t par, T const& t) {
+    if (!std::is_nothrow_copy_assignable_v<T>) par.threads = 1;
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      for (size_type i = begin; i < end; ++i) data_[i] = t;
+    });
+    return *this;
+  }
+
+  template <typename F>
+  void for_each_partition(parallel_t par, F const& f) {
+    parallel_for(par, total_size, [&](size_type begin, size_type end) {
+      f(data_ + begin, data_ + end);
+    });
+  }
+
+  T operator()(size_type idx) const { return data_[idx]; }
+
+  size_type capacity() const { return capacity_; }
+
+  void reserve(size_type n) {
+    if (n > capacity_) grow(n);
+  }
+
+  void push_back(T const& t) {
+    if (total_size == capacity_) {
+      T value(t);
+      reserve(std::max<size_type>(checked_mul<size_type>(total_size, 2), 1));
+      new (data_ + total_size) T(std::move(value));
+    } else {
+      new (data_ + total_size) T(t);
+    }
+    ++total_size;
+    ++dims[0];
+  }
+
+  template <typename... Args>
+  GridView<T, sizeof...(Args), I> reshape(Args... args) & {
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, sizeof...(Args));
+    return GridView<T, sizeof...(Args), I>(data_, new_dims);
+  }
+
+  template <typename... Args>
+  GridView<T const, sizeof...(Args), I> reshape(Args... args) const& {
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, sizeof...(Args));
+    return GridView<T const, sizeof...(Args), I>(data_, new_dims);
+  }
+
+  template <typename... Args>
+  Grid<T, sizeof...(Args), I> reshape(Args... args) && {
+    constexpr unsigned DD = sizeof...(Args);
+    size_type const new_dims[] = {static_cast<size_type>(args)...};
+    check_reshape(new_dims, DD);
+    Grid<T, DD, I> result;
+    for (unsigned i = 0; i < DD; ++i) result.dims[i] = new_dims[i];
+    result.data_ = std::exchange(data_, nullptr);
+    result.total_size = std::exchange(total_size, 0);
+    result.capacity_ = std::exchange(capacity_, 0);
+    dims[0] = 0;
+    return result;
+  }
+
+  T& operator()(size_type idx) { return data_[idx]; }
+
+  T& operator[](size_type idx) { return data_[idx]; }
+
+  T operator[](size_type idx) const { return data_[idx]; }
+
+  T* data() { return data_; }
+  T const* data() const { return data_; }
+
+  T* begin() { return data_; }
+  T* end() { return data_ + total_size; }
+  T const* begin() const { return data_; }
+  T const* end() const { return data_ + total_size; }
+
+  size_type size() const { return total_size; }
+  size_type extent(unsigned) const { return dims[0]; }
+
+  IndexRange<1, I> indices() const { return IndexRange<1, I>(dims); }
+
+  GridView<T, 1, I> view() { return GridView<T, 1, I>(data_, dims); }
+
+  GridView<T const, 1, I> view() const {
+    return GridView<T const, 1, I>(data_, dims);
+  }
+};
+
+// невладеющее представление с произвольными шагами: перестановка осей,
+// транспонирование и разворот осей за O(1), без копирования данных
+template <typename T, unsigned D, typename I = std::size_t>
+class GridView {
+ public:
+  using value_type = std::remove_const_t<T>;
+  using size_type = I;
+
+  template <typename TT, unsigned DD, typename II>
+  friend class Grid;
+
+ private:
+  // размер листового блока при материализации, чтобы он помещался в L1
+  static constexpr std::size_t tile_bytes = 16 * 1024;
+
+  T* origin;
+  size_type dims[D];
+  std::ptrdiff_t strides[D];
+
+  GridView(T* origin, size_type const* grid_dims) : origin(origin) {
+    std::ptrdiff_t stride = 1;
+    for (unsigned i = D; i-- > 0;) {
+      dims[i] = grid_dims[i];
+      strides[i] = stride;
+      stride *= static_cast<std::ptrdiff_t>(grid_dims[i]);
+    }
+  }
+
+  // кэш-независимое копирование: делим самую длинную ось пополам, пока блок
+  // не станет маленьким, затем копируем его строками вдоль последней оси
+  void copy_to(value_type* dst, size_type const* dst_strides,
+               size_type const* lo, size_type const* hi) const {
+    size_type volume = 1;
+    unsigned widest = 0;
+    for (unsigned i = 0; i < D; ++i) {
+      volume *= hi[i] - lo[i];
+      if (hi[i] - lo[i] > hi[widest] - lo[widest]) widest = i;
+    }
+    if (volume == 0) return;
+
+    if (volume * sizeof(T) > tile_bytes && hi[widest] - lo[widest] > 1) {
+      size_type const mid = lo[widest] + (hi[widest] - lo[widest]) / 2;
+      size_type first_hi[D], second_lo[D];
+      for (unsigned i = 0; i < D; ++i) {
+        first_hi[i] = hi[i];
+        second_lo[i] = lo[i];
+      }
+      first_hi[widest] = second_lo[widest] = mid;
+      copy_to(dst, dst_strides, lo, first_hi);
+      try {
+        copy_to(dst, dst_strides, second_lo, hi);
+      } catch (...) {
+        // вторая половина убрала за собой сама, первая готова целиком;
+        // строк в ней не больше volume
+        destroy_rows(dst, dst_strides, lo, first_hi, volume);
+        throw;
+      }
+      return;
+    }
+
+    size_type const row = hi[D - 1] - lo[D - 1];
+    size_type rows_done = 0;
+    try {
+      for_each_row(dst, dst_strides, lo, hi, [&](T* src, value_type* out) {
+        size_type x = 0;
+        try {
+          for (; x < row; ++x) {
+            new (out + x) value_type(*src);
+            src += strides[D - 1];
+          }
+        } catch (...) {
+          while (x-- > 0) out[x].~value_type();
+          throw;
+        }
+        ++rows_done;
+        return true;
+      });
+    } catch (...) {
+      destroy_rows(dst, dst_strides, lo, hi, rows_done);
+      throw;
+    }
+  }
+
+  // обходит строки блока [lo, hi) по порядку, пока f возвращает true
+  template <typename F>
+  void for_each_row(value_type* dst, size_type const* dst_strides,
+                    size_type const* lo, size_type const* hi, F f) const {
+    size_type idx[D];
+    for (unsigned i = 0; i < D; ++i) idx[i] = lo[i];
+    while (true) {
+      T* src = origin;
+      value_type* out = dst;
+      for (unsigned i = 0; i < D; ++i) {
+        src += static_cast<std::ptrdiff_t>(idx[i]) * strides[i];
+        out += idx[i] * dst_strides[i];
+      }
+      if (!f(src, out)) return;
+
+      unsigned axis = D - 1;
+      while (axis-- > 0) {
+        if (++idx[axis] < hi[axis]) break;
+        idx[axis] = lo[axis];
+      }
+      if (axis > D) return;
+    }
+  }
+
+  // разрушает первые rows строк блока, уже скопированные copy_to
+  void destroy_rows(value_type* dst, size_type const* dst_strides,
+                    size_type const* lo, size_type const* hi,
+                    size_type rows) const {
+    size_type const row = hi[D - 1] - lo[D - 1];
+    if (rows == 0 || row == 0) return;
+    for_each_row(dst, dst_strides, lo, hi, [&](T*, value_type* out) {
+      for (size_type x = 0; x < row; ++x) out[x].~value_type();
+      return --rows != 0;
+    });
+  }
+
+ public:
+  template <typename... Idx>
+  T& operator()(Idx... idx) const {
+    static_assert(sizeof...(Idx) == D, "wrong number of indices");
+    size_type const indices[] = {static_cast<size_type>(idx)...};
+    std::ptrdiff_t offset = 0;
+    for (unsigned i = 0; i < D; ++i) {
+      offset += static_cast<std::ptrdiff_t>(indices[i]) * strides[i];
+    }
+    return origin[offset];
+  }
+
+  // ось i результата -- ось axes[i] исходного представления
+  GridView permuted(std::array<unsigned, D> const& axes) const {
+    GridView result = *this;
+    bool seen[D] = {};
+    for (unsigned i = 0; i < D; ++i) {
+      if (axes[i] >= D || seen[axes[i]]) {
+        throw std::invalid_argument("axes are not a permutation");
+      }
+      seen[axes[i]] = true;
+      result.dims[i] = dims[axes[i]];
+      result.strides[i] = strides[axes[i]];
+    }
+    return result;
+  }
+
+  GridView transposed() const {
+    std::array<unsigned, D> axes;
+    for (unsigned i = 0; i < D; ++i) axes[i] = D - 1 - i;
+    return permuted(axes);
+  }
+
+  GridView reversed(unsigned axis) const {
+    GridView result = *this;
+    if (dims[axis] != 0) {
+      result.origin +=
+          static_cast<std::ptrdiff_t>(dims[axis] - 1) * strides[axis];
+    }
+    result.strides[axis] = -strides[axis];
+    return result;
+  }
+
+  size_type extent(unsigned axis) const { return dims[axis]; }
+
+  // копирует представление в новую непрерывную сетку
+  Grid<value_type, D, I> materialize() const {
+    Grid<value_type, D, I> result;
+    size_type dst_strides[D];
+    size_type lo[D], hi[D];
+    size_type total_size = 1;
+    for (unsigned i = D; i-- > 0;) {
+      result.dims[i] = dims[i];
+      dst_strides[i] = total_size;
+      lo[i] = 0;
+      hi[i] = dims[i];
+      total_size *= dims[i];
+    }
+    // пока копирование не закончено, result не владеет элементами: если
+    // копия бросит, copy_to сам разрушит уже построенные
+    result.data_ = Grid<value_type, D, I>::allocate(total_size);
+    result.capacity_ = total_size;
+    copy_to(result.data_, dst_strides, lo, hi);
+    result.total_size = total_size;
+    return result;
+  }
+};
+
+// экстенты, известные на этапе компиляции
+constexpr std::size_t dynamic = static_cast<std::size_t>(-1);
+
+template <std::size_t N>
+struct DynamicExtents {
+  std::size_t values[N];
+};
+
+template <>
+struct DynamicExtents<0> {};
+
+template <std::size_t... Es>
+class Extents : DynamicExtents<((Es == dynamic) + ... + 0u)> {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type rank = sizeof...(Es);
+  static constexpr size_type rank_dynamic = ((Es == dynamic) + ... + 0u);
+
+  static_assert(rank > 0, "Extents must have at least one dimension");
+
+ private:
+  using Base = DynamicExtents<rank_dynamic>;
+
+  static constexpr size_type static_extent(size_type i) {
+    constexpr size_type es[] = {Es...};
+    return es[i];
+  }
+
+  static constexpr size_type dynamic_index(size_type i) {
+    constexpr size_type es[] = {Es...};
+    size_type n = 0;
+    for (size_type k = 0; k < i; ++k) n += es[k] == dynamic;
+    return n;
+  }
+
+  template <size_type... Is>
+  constexpr size_type size(std::integer_sequence<size_type, Is...>) const {
+    size_type size = 1;
+    ((size = checked_mul(size, extent<Is>())), ...);
+    return size;
+  }
+
+  template <size_type... Is, typename... Idx>
+  constexpr size_type index(std::integer_sequence<size_type, Is...>,
+                            Idx... idx) const {
+    size_type const extents[] = {extent<Is>()...};
+    size_type const indices[] = {static_cast<size_type>(idx)...};
+    return row_major_offset(extents, indices, rank);
+  }
+
+ public:
+  constexpr Extents() = default;
+
+  template <typename... Args,
+            typename = std::enable_if_t<sizeof...(Args) == rank_dynamic &&
+                                        rank_dynamic != 0>>
+  constexpr Extents(Args... args) : Base{{static_cast<size_type>(args)...}} {}
+
+  template <size_type I>
+  constexpr size_type extent() const {
+    if constexpr (static_extent(I) == dynamic) {
+      return this->values[dynamic_index(I)];
+    } else {
+      return static_extent(I);
+    }
+  }
+
+  constexpr size_type extent(size_type i) const {
+    if constexpr (rank_dynamic == 0) {
+      return static_extent(i);
+    } else {
+      return static_extent(i) == dynamic ? this->values[dynamic_index(i)]
+                                         : static_extent(i);
+    }
+  }
+
+  constexpr size_type size() const {
+    return size(std::make_integer_sequence<size_type, rank>{});
+  }
+
+  // тот же порядок, что у Grid; статические экстенты -- константы, и после
+  // подстановки цикл разворачивается
+  template <typename... Idx>
+  constexpr size_type index(Idx... idx) const {
+    static_assert(sizeof...(Idx) == rank, "wrong number of indices");
+    return index(std::make_integer_sequence<size_type, rank>{}, idx...);
+  }
+};
+
+template <typename T, typename E, bool = (E::rank_dynamic == 0)>
+class StaticGrid;
+
+// все экстенты статические: данные лежат внутри объекта, работает в constexpr
+template <typename T, std::size_t... Es>
+class StaticGrid<T, Extents<Es...>, true> {
+ public:
+  using value_type = T;
+  using extents_type = Extents<Es...>;
+  using size_type = typename extents_type::size_type;
+
+  static constexpr size_type rank = extents_type::rank;
+
+ private:
+  T data[extents_type().size()];
+
+ public:
+  constexpr StaticGrid() : data{} {}
+
+  constexpr explicit StaticGrid(T const& t) : data{} {
+    for (size_type i = 0; i < size(); ++i) data[i] = t;
+  }
+
+  template <typename... Idx>
+  constexpr T operator()(Idx... idx) const {
+    return data[extents_type().index(idx...)];
+  }
+
+  template <typename... Idx>
+  constexpr T& operator()(Idx... idx) {
+    return data[extents_type().index(idx...)];
+  }
+
+  template <size_type I>
+  static constexpr size_type extent() {
+    return extents_type().template extent<I>();
+  }
+
+  static constexpr size_type size() { return extents_type().size(); }
+};
+
+template <typename T, std::size_t... Es>
+class StaticGrid<T, Extents<Es...>, false> : private Extents<Es...> {
+ public:
+  using value_type = T;
+  using extents_type = Extents<Es...>;
+  using size_type = typename extents_type::size_type;
+
+  static constexpr size_type rank = extents_type::rank;
+
+ private:
+  T* data;
+
+  extents_type const& extents() const { return *this; }
+
+  static T* allocate(size_type n) { return allocate_elements<T>(n); }
+
+  void clear() { destroy_elements(data, size()); }
+
+ public:
+  template <typename... Args, typename = std::enable_if_t<
+                                  sizeof...(Args) == extents_type::rank_dynamic>>
+  explicit StaticGrid(Args... args) : extents_type(args...) {
+    data = allocate(size());
+    for (size_type i = 0, n = size(); i < n; ++i) {
+      new (data + i) T();
+    }
+  }
+
+  StaticGrid(extents_type const& e, T const& t) : extents_type(e) {
+    data = allocate(size());
+    for (size_type i = 0, n = size(); i < n; ++i) {
+      new (data + i) T(t);
+    }
+  }
+
+  ~StaticGrid() { clear(); }
+
+  StaticGrid(StaticGrid const& other) : extents_type(other.extents()) {
+    data = allocate(size());
+    for (size_type i = 0, n = size(); i < n; ++i) {
+      new (data + i) T(other.data[i]);
+    }
+  }
+
+  StaticGrid(StaticGrid&& other) noexcept
+      : extents_type(other.extents()), data(other.data) {
+    other.data = nullptr;
+  }
+
+  StaticGrid& operator=(StaticGrid const& other) {
+    if (this == &other) return *this;
+    clear();
+    static_cast<extents_type&>(*this) = other.extents();
+    data = allocate(size());
+    for (size_type i = 0, n = size(); i < n; ++i) {
+      new (data + i) T(other.data[i]);
+    }
+    return *this;
+  }
+
+  StaticGrid& operator=(StaticGrid&& other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    static_cast<extents_type&>(*this) = other.extents();
+    data = other.data;
+    other.data = nullptr;
+    return *this;
+  }
+
+  template <typename... Idx>
+  T operator()(Idx... idx) const {
+    return data[extents().index(idx...)];
+  }
+
+  template <typename... Idx>
+  T& operator()(Idx... idx) {
+    return data[extents().index(idx...)];
+  }
+
+  template <size_type I>
+  size_type extent() const {
+    return extents().template extent<I>();
+  }
+
+  size_type size() const { return extents().size(); }
+};
+
+// разреженная сетка: память выделяется только под блоки B^D, в которые писали
+template <typename T, unsigned D, unsigned B = 8, typename I = std::size_t>
+class SparseGrid {
+ public:
+  using value_type = T;
+  using size_type = I;
+  using index_type = std::array<size_type, D>;
+
+  static_assert(B != 0 && (B & (B - 1)) == 0,
+                "block side must be a power of two");
+
+  static constexpr size_type block_volume = [] {
+    size_type volume = 1;
+    for (unsigned i = 0; i < D; ++i) volume *= B;
+    return volume;
+  }();
+
+ private:
+  index_type dims;
+  index_type block_dims;
+  size_type cells = 1;
+  T fill;
+  std::unordered_map<size_type, std::vector<T>> blocks;
+
+  template <typename Tuple, std::size_t... Is>
+  SparseGrid(Tuple const& args, std::index_sequence<Is...>)
+      : dims{static_cast<size_type>(std::get<Is>(args))...}, fill() {
+    if constexpr (std::tuple_size_v<Tuple> == D + 1) {
+      fill = static_cast<T>(std::get<D>(args));
+    }
+    // объём обязан помещаться в size_type: от него зависят ключи блоков
+    for (unsigned i = 0; i < D; ++i) {
+      cells = checked_mul(cells, dims[i]);
+      block_dims[i] = (dims[i] + B - 1) / B;
+    }
+  }
+
+  std::pair<size_type, size_type> locate(index_type const& idx) const {
+    size_type key = 0, offset = 0;
+    for (unsigned i = 0; i < D; ++i) {
+      key = key * block_dims[i] + idx[i] / B;
+      offset = offset * B + idx[i] % B;
+    }
+    return {key, offset};
+  }
+
+  template <typename Self, typename F>
+  static void visit(Self& self, F& f) {
+    for (auto& [key, block] : self.blocks) {
+      index_type base;
+      size_type rest = key;
+      for (unsigned i = D; i-- > 0;) {
+        base[i] = rest % self.block_dims[i] * B;
+        rest /= self.block_dims[i];
+      }
+      for (size_type offset = 0; offset < block_volume; ++offset) {
+        index_type idx;
+        bool inside = true;
+        size_type in_block = offset;
+        for (unsigned i = D; i-- > 0;) {
+          idx[i] = base[i] + in_block % B;
+          in_block /= B;
+          inside = inside && idx[i] < self.dims[i];
+        }
+        if (inside) f(static_cast<index_type const&>(idx), block[offset]);
+      }
+    }
+  }
+
+ public:
+  template <typename... Args>
+  explicit SparseGrid(Args... args)
+      : SparseGrid(std::make_tuple(args...), std::make_index_sequence<D>{}) {
+    static_assert(sizeof...(Args) == D || sizeof...(Args) == D + 1,
+                  "expected D extents and an optional default value");
+  }
+
+  // непустая ячейка не создаётся при чтении
+  template <typename... Idx>
+  T operator()(Idx... idx) const {
+    auto [key, offset] = locate(index_type{static_cast<size_type>(idx)...});
+    auto it = blocks.find(key);
+    return it == blocks.end() ? fill : it->second[offset];
+  }
+
+  template <typename... Idx>
+  T& operator()(Idx... idx) {
+    auto [key, offset] = locate(index_type{static_cast<size_type>(idx)...});
+    auto it = blocks.find(key);
+    if (it == blocks.end()) {
+      it = blocks.emplace(key, std::vector<T>(block_volume, fill)).first;
+    }
+    return it->second[offset];
+  }
+
+  SparseGrid& operator=(T const& t) {
+    blocks.clear();
+    fill = t;
+    return *this;
+  }
+
+  // выбрасывает блоки, в которых остались только значения по умолчанию
+  void shrink() {
+    for (auto it = blocks.begin(); it != blocks.end();) {
+      bool empty = true;
+      for (auto const& value : it->second) empty = empty && value == fill;
+      it = empty ? blocks.erase(it) : std::next(it);
+    }
+  }
+
+  // обходит только занятые блоки: f(index_type const&, T&)
+  template <typename F>
+  void for_each(F&& f) {
+    visit(*this, f);
+  }
+
+  template <typename F>
+  void for_each(F&& f) const {
+    visit(*this, f);
+  }
+
+  size_type extent(unsigned axis) const { return dims[axis]; }
+  size_type size() const { return cells; }
+  size_type block_count() const { return blocks.size(); }
+  T const& default_value() const { return fill; }
+};
+
+#endif
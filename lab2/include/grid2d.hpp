@@ -0,0 +1,158 @@
+#ifndef GRID2D_HPP
+#define GRID2D_HPP
+
+#include <cstddef>
+#include <new>
+
+#include "checked_mul.hpp"
+
+template <typename T, typename I = std::size_t>
+class Grid final {
+ public:
+  using value_type = T;
+  using size_type = I;
+
+ private:
+  T *data_;
+  size_type y_size, x_size;
+
+  Grid(T *data, size_type y_size, size_type x_size)
+      : data_(data), y_size(y_size), x_size(x_size) {}
+
+  static T *allocate(size_type n) {
+    return static_cast<T *>(
+        ::operator new(checked_mul<std::size_t>(sizeof(T), n)));
+  }
+
+  // task 1:
+  void clear() {
+    if (data_) {
+      for (size_type i = 0; i < y_size * x_size; ++i) {
+        data_[i].~T();
+      }
+      ::operator delete(data_);  // ыффективность
+      data_ = nullptr;
+    }
+  }
+
+ public:
+  Grid(T const &t) : y_size(1), x_size(1) {
+    data_ = static_cast<T *>(::operator new(sizeof(T)));
+    new (data_) T(t);
+  }
+
+  Grid(size_type y_size, size_type x_size) : y_size(y_size), x_size(x_size) {
+    data_ = allocate(checked_mul(y_size, x_size));
+    for (size_type i = 0; i < y_size * x_size; ++i) {
+      new (data_ + i) T();
+    }
+  }
+
+  Grid(size_type y_size, size_type x_size, T const &t)
+      : y_size(y_size), x_size(x_size) {
+    data_ = allocate(checked_mul(y_size, x_size));
+    for (size_type i = 0; i < y_size * x_size; ++i) {
+      new (data_ + i) T(t);
+    }
+  }
+
+  ~Grid() { clear(); }
+
+  Grid(Grid const &other) : y_size(other.y_size), x_size(other.x_size) {
+    data_ = allocate(y_size * x_size);
+    for (size_type i = 0; i < y_size * x_size; ++i) {
+      new (data_ + i) T(other.data_[i]);
+    }
+  }
+
+  Grid(Grid &&other) noexcept  // ыффективность
+      : data_(other.data_), y_size(other.y_size), x_size(other.x_size) {
+    other.data_ = nullptr;
+    other.y_size = 0;
+    other.x_size = 0;
+  }
+
+  Grid &operator=(Grid const &other) {
+    if (this == &other) return *this;
+    clear();
+    y_size = other.y_size;
+    x_size = other.x_size;
+    data_ = allocate(y_size * x_size);
+    for (size_type i = 0; i < y_size * x_size; ++i) {
+      new (data_ + i) T(other.data_[i]);
+    }
+    return *this;
+  }
+
+  Grid &operator=(Grid &&other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    data_ = other.data_;
+    y_size = other.y_size;
+    x_size = other.x_size;
+    other.data_ = nullptr;
+    other.y_size = 0;
+    other.x_size = 0;
+    return *this;
+  }
+
+  // task 2:
+  // строка как span: U -- T или T const, константность берётся от сетки
+  template <typename U>
+  class BasicRowProxy {
+    U *row_data;
+    size_type x_size;
+
+   public:
+    BasicRowProxy(U *row_data, size_type x_size)
+        : row_data(row_data), x_size(x_size) {}
+
+    U &operator[](size_type x_idx) const { return row_data[x_idx]; }
+
+    U *begin() const { return row_data; }
+    U *end() const { return row_data + x_size; }
+    size_type size() const { return x_size; }
+  };
+
+  using RowProxy = BasicRowProxy<T>;
+  using ConstRowProxy = BasicRowProxy<T const>;
+
+  RowProxy operator[](size_type y_idx) {
+    return RowProxy(data_ + y_idx * x_size, x_size);
+  }
+  ConstRowProxy operator[](size_type y_idx) const {
+    return ConstRowProxy(data_ + y_idx * x_size, x_size);
+  }
+
+  // base:
+  T operator()(size_type y_idx, size_type x_idx) const {
+    return data_[y_idx * x_size + x_idx];
+  }
+
+  T &operator()(size_type y_idx, size_type x_idx) {
+    return data_[y_idx * x_size + x_idx];
+  }
+
+  Grid &operator=(T const &t) {
+    for (auto it = data_, last = data_ + x_size * y_size; it != last; ++it) {
+      *it = t;
+    }
+    return *this;
+  }
+
+  // непрерывное хранение: указатели годятся для std-алгоритмов
+  T *data() { return data_; }
+  T const *data() const { return data_; }
+
+  T *begin() { return data_; }
+  T *end() { return data_ + y_size * x_size; }
+  T const *begin() const { return data_; }
+  T const *end() const { return data_ + y_size * x_size; }
+
+  size_type size() const { return y_size * x_size; }
+
+  size_type get_y_size() const { return y_size; }
+  size_type get_x_size() const { return x_size; }
+};
+
+#endif
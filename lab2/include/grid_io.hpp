@@ -0,0 +1,406 @@
+#ifndef GRID_IO_HPP
+#define GRID_IO_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+
+// Потоковый формат: сетка пишется и читается слоями по первой оси, в памяти
+// одновременно лежит только один чанк (slabs_per_chunk слоёв).
+//
+//   header: "GRID", byte order, rank, sizeof(T), dims[rank], slabs_per_chunk
+//   chunk:  codec (u32), stored bytes (u64), payload
+//   index:  chunk count (u64), offset of each chunk (u64)
+//   footer: offset of index (u64), "GIDX"
+//
+// Смещения отсчитываются от начала сетки ("GRID"), так что до и после неё
+// в потоке могут лежать другие данные. Порядок байт -- родной для машины,
+// при чтении он проверяется.
+enum class GridCodec : std::uint32_t { none = 0, rle = 1 };
+
+namespace grid_io {
+
+constexpr char header_magic[4] = {'G', 'R', 'I', 'D'};
+constexpr char footer_magic[4] = {'G', 'I', 'D', 'X'};
+constexpr std::uint32_t byte_order = 0x01020304;
+
+template <typename U>
+void put(std::ostream& out, U value) {
+  out.write(reinterpret_cast<char const*>(&value), sizeof(U));
+}
+
+template <typename U>
+U get(std::istream& in) {
+  U value;
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(U))) {
+    throw std::runtime_error("grid_io: unexpected end of stream");
+  }
+  return value;
+}
+
+// RLE по элементам: (длина серии u32, значение); годится для сеток, где
+// много одинаковых значений подряд
+template <typename T>
+void rle_encode(T const* data, std::size_t count, std::vector<char>& out) {
+  out.clear();
+  for (std::size_t i = 0; i < count;) {
+    std::uint32_t run = 1;
+    while (i + run < count && run != UINT32_MAX &&
+           std::memcmp(data + i, data + i + run, sizeof(T)) == 0) {
+      ++run;
+    }
+    std::size_t const at = out.size();
+    out.resize(at + sizeof(run) + sizeof(T));
+    std::memcpy(out.data() + at, &run, sizeof(run));
+    std::memcpy(out.data() + at + sizeof(run), data + i, sizeof(T));
+    i += run;
+  }
+}
+
+template <typename T>
+void rle_decode(char const* in, std::size_t bytes, T* data,
+                std::size_t count) {
+  std::size_t filled = 0;
+  for (std::size_t at = 0; at + sizeof(std::uint32_t) + sizeof(T) <= bytes;
+       at += sizeof(std::uint32_t) + sizeof(T)) {
+    std::uint32_t run;
+    std::memcpy(&run, in + at, sizeof(run));
+    if (run > count - filled) {
+      throw std::runtime_error("grid_io: corrupt rle chunk");
+    }
+    for (std::uint32_t k = 0; k < run; ++k) {
+      std::memcpy(data + filled + k, in + at + sizeof(run), sizeof(T));
+    }
+    filled += run;
+  }
+  if (filled != count) throw std::runtime_error("grid_io: corrupt rle chunk");
+}
+
+}  // namespace grid_io
+
+template <typename T, unsigned D, typename I = std::size_t>
+class GridWriter {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "only trivially copyable elements can be streamed");
+
+ public:
+  using size_type = I;
+
+ private:
+  std::ostream& out;
+  std::array<size_type, D> dims;
+  GridCodec codec;
+  size_type slabs_per_chunk;
+  size_type slab_size;
+  size_type slabs_written = 0;
+  std::uint64_t offset = 0;
+  std::vector<T> chunk;
+  std::vector<char> encoded;
+  std::vector<std::uint64_t> index;
+  bool finished = false;
+
+  template <typename U>
+  void put(U value) {
+    grid_io::put(out, value);
+    offset += sizeof(U);
+  }
+
+  void flush_chunk() {
+    if (chunk.empty()) return;
+    index.push_back(offset);
+    char const* payload = reinterpret_cast<char const*>(chunk.data());
+    std::uint64_t bytes = chunk.size() * sizeof(T);
+    GridCodec used = GridCodec::none;
+    if (codec == GridCodec::rle) {
+      grid_io::rle_encode(chunk.data(), chunk.size(), encoded);
+      if (encoded.size() < bytes) {
+        used = GridCodec::rle;
+        payload = encoded.data();
+        bytes = encoded.size();
+      }
+    }
+    put(static_cast<std::uint32_t>(used));
+    put(bytes);
+    out.write(payload, static_cast<std::streamsize>(bytes));
+    offset += bytes;
+    chunk.clear();
+    if (!out) throw std::runtime_error("grid_io: write failed");
+  }
+
+ public:
+  GridWriter(std::ostream& out, std::array<size_type, D> const& dims,
+             GridCodec codec = GridCodec::none, size_type slabs_per_chunk = 1)
+      : out(out),
+        dims(dims),
+        codec(codec),
+        slabs_per_chunk(slabs_per_chunk != 0 ? slabs_per_chunk : 1),
+        slab_size(1) {
+    for (unsigned i = 1; i < D; ++i) {
+      slab_size = checked_mul(slab_size, dims[i]);
+    }
+    out.write(grid_io::header_magic, sizeof(grid_io::header_magic));
+    offset += sizeof(grid_io::header_magic);
+    put(grid_io::byte_order);
+    put(static_cast<std::uint32_t>(D));
+    put(static_cast<std::uint32_t>(sizeof(T)));
+    for (auto dim : dims) put(static_cast<std::uint64_t>(dim));
+    put(static_cast<std::uint64_t>(this->slabs_per_chunk));
+    chunk.reserve(this->slabs_per_chunk * slab_size);
+    if (!out) throw std::runtime_error("grid_io: write failed");
+  }
+
+  GridWriter(GridWriter const&) = delete;
+  GridWriter& operator=(GridWriter const&) = delete;
+
+  // деструктор дописывает индекс, но ошибки при этом теряет -- лучше
+  // вызывать finish() явно
+  ~GridWriter() {
+    try {
+      finish();
+    } catch (...) {
+    }
+  }
+
+  // slab -- slab_elements() элементов, следующий слой по первой оси
+  void write_slab(T const* slab) {
+    if (slabs_written == dims[0]) {
+      throw std::logic_error("grid_io: all slabs already written");
+    }
+    chunk.insert(chunk.end(), slab, slab + slab_size);
+    ++slabs_written;
+    if (chunk.size() == slabs_per_chunk * slab_size) flush_chunk();
+  }
+
+  void finish() {
+    if (finished) return;
+    if (slabs_written != dims[0]) {
+      throw std::logic_error("grid_io: grid is incomplete");
+    }
+    finished = true;
+    flush_chunk();
+    std::uint64_t const index_offset = offset;
+    put(static_cast<std::uint64_t>(index.size()));
+    for (auto chunk_offset : index) put(chunk_offset);
+    put(index_offset);
+    out.write(grid_io::footer_magic, sizeof(grid_io::footer_magic));
+    out.flush();
+    if (!out) throw std::runtime_error("grid_io: write failed");
+  }
+
+  size_type slab_elements() const { return slab_size; }
+};
+
+template <typename T, unsigned D, typename I = std::size_t>
+class GridReader {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "only trivially copyable elements can be streamed");
+
+ public:
+  using size_type = I;
+
+ private:
+  std::istream& in;
+  // позиция "GRID" в потоке, к ней прибавляются все смещения
+  std::streamoff base;
+  std::streamoff first_chunk = 0;
+  std::array<size_type, D> dims;
+  size_type slabs_per_chunk;
+  size_type slab_size;
+  size_type chunk_count;
+  size_type slabs_read = 0;
+  std::vector<T> chunk;
+  std::size_t chunk_pos = 0;
+  std::vector<char> encoded;
+  std::vector<std::uint64_t> index;
+  bool trailer_skipped = false;
+
+  void read_chunk_here(std::vector<T>& target, size_type slabs) {
+    auto const codec =
+        static_cast<GridCodec>(grid_io::get<std::uint32_t>(in));
+    auto const bytes = grid_io::get<std::uint64_t>(in);
+    target.resize(slabs * slab_size);
+    if (codec == GridCodec::none) {
+      if (bytes != target.size() * sizeof(T) ||
+          !in.read(reinterpret_cast<char*>(target.data()),
+                   static_cast<std::streamsize>(bytes))) {
+        throw std::runtime_error("grid_io: corrupt chunk");
+      }
+    } else if (codec == GridCodec::rle) {
+      encoded.resize(bytes);
+      if (!in.read(encoded.data(), static_cast<std::streamsize>(bytes))) {
+        throw std::runtime_error("grid_io: unexpected end of stream");
+      }
+      grid_io::rle_decode(encoded.data(), bytes, target.data(), target.size());
+    } else {
+      throw std::runtime_error("grid_io: unknown codec");
+    }
+  }
+
+  size_type slabs_in_chunk(size_type chunk_idx) const {
+    size_type const first = chunk_idx * slabs_per_chunk;
+    return std::min(slabs_per_chunk, dims[0] - first);
+  }
+
+  // число чанков, смещения, смещение индекса и "GIDX"
+  void skip_trailer() {
+    if (trailer_skipped) return;
+    trailer_skipped = true;
+    in.ignore(static_cast<std::streamsize>((chunk_count + 2) *
+                                           sizeof(std::uint64_t)));
+    char magic[4];
+    if (!in.read(magic, 4) ||
+        std::memcmp(magic, grid_io::footer_magic, 4) != 0) {
+      throw std::runtime_error("grid_io: missing chunk index");
+    }
+  }
+
+  // индекс ищется не от конца потока, а по заголовкам чанков: после сетки
+  // могут идти другие данные. Записанный индекс сверяется с найденным
+  void load_index() {
+    if (!index.empty() || chunk_count == 0) return;
+    auto const resume = in.tellg();
+    std::vector<std::uint64_t> found(chunk_count);
+    std::uint64_t at = static_cast<std::uint64_t>(first_chunk);
+    for (auto& chunk_offset : found) {
+      chunk_offset = at;
+      in.seekg(base + static_cast<std::streamoff>(at + sizeof(std::uint32_t)));
+      at += sizeof(std::uint32_t) + sizeof(std::uint64_t) +
+            grid_io::get<std::uint64_t>(in);
+    }
+    in.seekg(base + static_cast<std::streamoff>(at));
+    if (grid_io::get<std::uint64_t>(in) != chunk_count) {
+      throw std::runtime_error("grid_io: corrupt chunk index");
+    }
+    for (auto chunk_offset : found) {
+      if (grid_io::get<std::uint64_t>(in) != chunk_offset) {
+        throw std::runtime_error("grid_io: corrupt chunk index");
+      }
+    }
+    char magic[4];
+    if (grid_io::get<std::uint64_t>(in) != at || !in.read(magic, 4) ||
+        std::memcmp(magic, grid_io::footer_magic, 4) != 0) {
+      throw std::runtime_error("grid_io: missing chunk index");
+    }
+    index = std::move(found);
+    in.seekg(resume);
+  }
+
+ public:
+  explicit GridReader(std::istream& in) : in(in), base(in.tellg()) {
+    char magic[4];
+    if (!in.read(magic, 4) ||
+        std::memcmp(magic, grid_io::header_magic, 4) != 0) {
+      throw std::runtime_error("grid_io: not a grid stream");
+    }
+    if (grid_io::get<std::uint32_t>(in) != grid_io::byte_order) {
+      throw std::runtime_error("grid_io: foreign byte order");
+    }
+    if (grid_io::get<std::uint32_t>(in) != D ||
+        grid_io::get<std::uint32_t>(in) != sizeof(T)) {
+      throw std::runtime_error("grid_io: rank or element size mismatch");
+    }
+    slab_size = 1;
+    for (unsigned i = 0; i < D; ++i) {
+      dims[i] = static_cast<size_type>(grid_io::get<std::uint64_t>(in));
+      if (i != 0) slab_size = checked_mul(slab_size, dims[i]);
+    }
+    slabs_per_chunk =
+        static_cast<size_type>(grid_io::get<std::uint64_t>(in));
+    if (slabs_per_chunk == 0) throw std::runtime_error("grid_io: bad header");
+    chunk_count = (dims[0] + slabs_per_chunk - 1) / slabs_per_chunk;
+    // tellg() == -1 у потоков без позиционирования: тогда доступен только
+    // последовательный read_slab
+    if (base >= 0) first_chunk = in.tellg() - base;
+  }
+
+  std::array<size_type, D> const& extents() const { return dims; }
+  size_type slab_elements() const { return slab_size; }
+  size_type chunk_size() const { return slabs_per_chunk; }
+  size_type chunks() const { return chunk_count; }
+
+  // следующий слой по порядку; false, когда слои кончились. После
+  // последнего слоя индекс и footer пропускаются, и поток стоит сразу за
+  // сеткой
+  bool read_slab(T* slab) {
+    if (slabs_read == dims[0]) {
+      skip_trailer();
+      return false;
+    }
+    if (chunk_pos == chunk.size()) {
+      read_chunk_here(chunk, slabs_in_chunk(slabs_read / slabs_per_chunk));
+      chunk_pos = 0;
+    }
+    std::memcpy(slab, chunk.data() + chunk_pos, slab_size * sizeof(T));
+    chunk_pos += slab_size;
+    if (++slabs_read == dims[0]) skip_trailer();
+    return true;
+  }
+
+  // произвольный доступ по индексу чанков, поток должен поддерживать
+  // tellg/seekg; возвращает число прочитанных слоёв
+  size_type read_chunk(size_type chunk_idx, std::vector<T>& out) {
+    if (chunk_idx >= chunk_count) {
+      throw std::out_of_range("grid_io: chunk index out of range");
+    }
+    load_index();
+    auto const resume = in.tellg();
+    in.seekg(base + static_cast<std::streamoff>(index[chunk_idx]));
+    size_type const slabs = slabs_in_chunk(chunk_idx);
+    read_chunk_here(out, slabs);
+    in.seekg(resume);
+    return slabs;
+  }
+};
+
+// slabs_per_chunk не выводит I: write_grid(out, grid, codec, 4) годится
+// для сетки с любым типом индекса
+template <typename T, unsigned D, typename I>
+void write_grid(std::ostream& out, Grid<T, D, I> const& grid,
+                GridCodec codec = GridCodec::none,
+                std::size_t slabs_per_chunk = 1) {
+  std::array<I, D> dims;
+  for (unsigned i = 0; i < D; ++i) dims[i] = grid.extent(i);
+  GridWriter<T, D, I> writer(out, dims, codec,
+                             static_cast<I>(slabs_per_chunk));
+  for (I slab = 0; slab < dims[0]; ++slab) {
+    if constexpr (D == 1) {
+      writer.write_slab(grid.data() + slab);
+    } else {
+      writer.write_slab(grid.plane(slab).data());
+    }
+  }
+  writer.finish();
+}
+
+namespace grid_io {
+
+template <typename T, unsigned D, typename I, std::size_t... Is>
+Grid<T, D, I> make_grid(std::array<I, D> const& dims,
+                        std::index_sequence<Is...>) {
+  return Grid<T, D, I>(dims[Is]...);
+}
+
+}  // namespace grid_io
+
+template <typename T, unsigned D, typename I = std::size_t>
+Grid<T, D, I> read_grid(std::istream& in) {
+  GridReader<T, D, I> reader(in);
+  auto grid = grid_io::make_grid<T, D, I>(reader.extents(),
+                                          std::make_index_sequence<D>{});
+  for (T* slab = grid.data(); reader.read_slab(slab);) {
+    slab += reader.slab_elements();
+  }
+  return grid;
+}
+
+#endif
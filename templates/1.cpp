@@ -1,4 +1,14 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -6,19 +16,100 @@ template <typename T>
 using Array = std::vector<T>;
 
 // 1. ScopePtr
+// удалители: пустые классы, ScopePtr с ними занимает один указатель
 template <typename T>
-class ScopePtr {
+struct DefaultDelete {
+  void operator()(T* ptr) const { delete ptr; }
+};
+
+template <typename T>
+struct DefaultDelete<T[]> {
+  void operator()(T* ptr) const { delete[] ptr; }
+};
+
+// для объектов в памяти из ::operator new(size, std::align_val_t{Align})
+template <typename T, size_t Align = alignof(T)>
+struct AlignedDelete {
+  void operator()(T* ptr) const {
+    ptr->~T();
+    ::operator delete(ptr, std::align_val_t{Align});
+  }
+};
+
+// возвращает блок в пул со статическими allocate()/deallocate(void*)
+template <typename T, typename Pool>
+struct PoolDelete {
+  void operator()(T* ptr) const {
+    ptr->~T();
+    Pool::deallocate(ptr);
+  }
+};
+
+// то же для пула-объекта (арены) с deallocate(void*): указатель на арену
+// хранится в удалителе, и ScopePtr занимает два указателя. Без арены
+// удалитель не создаётся, поэтому ScopePtr без удалителя с ним не собрать
+template <typename T, typename Arena>
+struct ArenaDelete {
+  Arena* arena = nullptr;
+
+  ArenaDelete(Arena* arena) : arena(arena) {}
+
+  void operator()(T* ptr) const {
+    ptr->~T();
+    arena->deallocate(ptr);
+  }
+};
+
+// пустой удалитель хранится как база (EBO) и места не занимает
+template <typename D, bool = std::is_empty_v<D> && !std::is_final_v<D>>
+class DeleterHolder : private D {
+ protected:
+  DeleterHolder() = default;
+  explicit DeleterHolder(D deleter) : D(std::move(deleter)) {}
+
+ public:
+  D& get_deleter() { return *this; }
+  const D& get_deleter() const { return *this; }
+};
+
+template <typename D>
+class DeleterHolder<D, false> {
+ private:
+  D m_deleter{};
+
+ protected:
+  DeleterHolder() = default;
+  explicit DeleterHolder(D deleter) : m_deleter(std::move(deleter)) {}
+
+ public:
+  D& get_deleter() { return m_deleter; }
+  const D& get_deleter() const { return m_deleter; }
+};
+
+template <typename T, typename Deleter = DefaultDelete<T>>
+class ScopePtr : public DeleterHolder<Deleter> {
  private:
   T* m_ptr;
 
  public:
+  // только если удалитель можно создать сам по себе
+  template <typename D = Deleter,
+            typename = std::enable_if_t<std::is_default_constructible_v<D>>>
   ScopePtr() : m_ptr{nullptr} {}
+  template <typename D = Deleter,
+            typename = std::enable_if_t<std::is_default_constructible_v<D>>>
   explicit ScopePtr(T* ptr) : m_ptr{ptr} {}
+  ScopePtr(T* ptr, Deleter deleter)
+      : DeleterHolder<Deleter>(std::move(deleter)), m_ptr{ptr} {}
   ScopePtr(const ScopePtr&) = delete;
   ScopePtr& operator=(const ScopePtr&) = delete;
-  ScopePtr(ScopePtr&& other) : m_ptr{std::exchange(other.m_ptr, nullptr)} {}
+  ScopePtr(ScopePtr&& other)
+      : DeleterHolder<Deleter>(std::move(other.get_deleter())),
+        m_ptr{std::exchange(other.m_ptr, nullptr)} {}
   ScopePtr& operator=(ScopePtr&& other) {
-    std::swap(m_ptr, other.m_ptr);
+    using std::swap;
+    swap(m_ptr, other.m_ptr);
+    swap(this->get_deleter(), other.get_deleter());
     return *this;
   }
   explicit operator bool() const { return m_ptr != nullptr; }
@@ -30,28 +121,41 @@ class ScopePtr {
     m_ptr = nullptr;
     return old_ptr;
   }
-  void reset(T* new_ptr) {
-    delete m_ptr;
+  void reset(T* new_ptr = nullptr) {
+    if (m_ptr) this->get_deleter()(m_ptr);
     m_ptr = new_ptr;
   }
 
-  ~ScopePtr() { delete m_ptr; }
+  ~ScopePtr() {
+    if (m_ptr) this->get_deleter()(m_ptr);
+  }
 };
 
 // для массивов
-template <typename T>
-class ScopePtr<T[]> {
+template <typename T, typename Deleter>
+class ScopePtr<T[], Deleter> : public DeleterHolder<Deleter> {
  private:
   T* m_ptr;
 
  public:
+  // только если удалитель можно создать сам по себе
+  template <typename D = Deleter,
+            typename = std::enable_if_t<std::is_default_constructible_v<D>>>
   ScopePtr() : m_ptr{nullptr} {}
+  template <typename D = Deleter,
+            typename = std::enable_if_t<std::is_default_constructible_v<D>>>
   explicit ScopePtr(T* ptr) : m_ptr{ptr} {}
+  ScopePtr(T* ptr, Deleter deleter)
+      : DeleterHolder<Deleter>(std::move(deleter)), m_ptr{ptr} {}
   ScopePtr(const ScopePtr&) = delete;
   ScopePtr& operator=(const ScopePtr&) = delete;
-  ScopePtr(ScopePtr&& other) : m_ptr{std::exchange(other.m_ptr, nullptr)} {}
+  ScopePtr(ScopePtr&& other)
+      : DeleterHolder<Deleter>(std::move(other.get_deleter())),
+        m_ptr{std::exchange(other.m_ptr, nullptr)} {}
   ScopePtr& operator=(ScopePtr&& other) {
-    std::swap(m_ptr, other.m_ptr);
+    using std::swap;
+    swap(m_ptr, other.m_ptr);
+    swap(this->get_deleter(), other.get_deleter());
     return *this;
   }
   explicit operator bool() const { return m_ptr != nullptr; }
@@ -62,14 +166,20 @@ class ScopePtr<T[]> {
     m_ptr = nullptr;
     return old_ptr;
   }
-  void reset(T* new_ptr) {
-    delete[] m_ptr;
+  void reset(T* new_ptr = nullptr) {
+    if (m_ptr) this->get_deleter()(m_ptr);
     m_ptr = new_ptr;
   }
 
-  ~ScopePtr() { delete[] m_ptr; }
+  ~ScopePtr() {
+    if (m_ptr) this->get_deleter()(m_ptr);
+  }
 };
 
+static_assert(sizeof(ScopePtr<int>) == sizeof(int*));
+static_assert(sizeof(ScopePtr<int[]>) == sizeof(int*));
+static_assert(sizeof(ScopePtr<int, AlignedDelete<int, 64>>) == sizeof(int*));
+
 // 2. is_same
 template <typename T, typename U>
 struct is_same {
@@ -126,3 +236,366 @@ void flatten(const Array<Array<T>>& array, std::ostream& out) {
     flatten(subarray, out);
   }
 }
+
+// ленивый обход Array любой вложенности как одного плоского диапазона.
+// FlatIterator<T> идёт по Array<T>; для Array<Array<T>> он держит внешний
+// итератор и вложенный FlatIterator<T>, пустые подмассивы пропускаются
+template <typename T>
+struct flat_value {
+  using type = T;
+};
+
+template <typename T>
+struct flat_value<Array<T>> {
+  using type = typename flat_value<T>::type;
+};
+
+template <typename T>
+using flat_value_t = typename flat_value<T>::type;
+
+template <typename T>
+class FlatIterator {
+ private:
+  typename Array<T>::const_iterator m_it;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const T*;
+  // у Array<bool> это bool по значению
+  using reference = typename Array<T>::const_reference;
+
+  FlatIterator() = default;
+  FlatIterator(const Array<T>& array, bool end)
+      : m_it{end ? array.end() : array.begin()} {}
+
+  reference operator*() const { return *m_it; }
+  pointer operator->() const { return &*m_it; }
+  FlatIterator& operator++() {
+    ++m_it;
+    return *this;
+  }
+  FlatIterator operator++(int) {
+    auto old = *this;
+    ++*this;
+    return old;
+  }
+  bool operator==(const FlatIterator& other) const {
+    return m_it == other.m_it;
+  }
+  bool operator!=(const FlatIterator& other) const {
+    return !(*this == other);
+  }
+};
+
+template <typename T>
+class FlatIterator<Array<T>> {
+ private:
+  using Outer = typename Array<Array<T>>::const_iterator;
+
+  Outer m_outer;
+  Outer m_outer_end;
+  FlatIterator<T> m_inner;
+  FlatIterator<T> m_inner_end;
+
+  // встаёт на первый элемент, начиная с текущего подмассива
+  void settle() {
+    for (; m_outer != m_outer_end; ++m_outer) {
+      m_inner = FlatIterator<T>(*m_outer, false);
+      m_inner_end = FlatIterator<T>(*m_outer, true);
+      if (m_inner != m_inner_end) return;
+    }
+  }
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = flat_value_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = typename FlatIterator<T>::reference;
+
+  FlatIterator() = default;
+  FlatIterator(const Array<Array<T>>& array, bool end)
+      : m_outer{end ? array.end() : array.begin()}, m_outer_end{array.end()} {
+    if (!end) settle();
+  }
+
+  reference operator*() const { return *m_inner; }
+  pointer operator->() const { return &*m_inner; }
+  FlatIterator& operator++() {
+    if (++m_inner == m_inner_end) {
+      ++m_outer;
+      settle();
+    }
+    return *this;
+  }
+  FlatIterator operator++(int) {
+    auto old = *this;
+    ++*this;
+    return old;
+  }
+  bool operator==(const FlatIterator& other) const {
+    return m_outer == other.m_outer &&
+           (m_outer == m_outer_end || m_inner == other.m_inner);
+  }
+  bool operator!=(const FlatIterator& other) const {
+    return !(*this == other);
+  }
+};
+
+template <typename T>
+class FlatView {
+ private:
+  const Array<T>* m_array;
+
+ public:
+  explicit FlatView(const Array<T>& array) : m_array{&array} {}
+
+  FlatIterator<T> begin() const { return FlatIterator<T>(*m_array, false); }
+  FlatIterator<T> end() const { return FlatIterator<T>(*m_array, true); }
+};
+
+template <typename T>
+FlatView<T> flat_view(const Array<T>& array) {
+  return FlatView<T>(array);
+}
+
+// пишет в буфер вызывающего через std::to_chars и отдаёт его потоку
+// целиком, когда следующее значение уже не помещается
+class ChunkWriter {
+ private:
+  std::ostream& m_out;
+  char* m_begin;
+  char* m_pos;
+  char* m_end;
+
+ public:
+  // хватает на любое число и разделитель
+  static constexpr size_t min_buffer = 64;
+
+  ChunkWriter(std::ostream& out, char* buffer, size_t size)
+      : m_out{out}, m_begin{buffer}, m_pos{buffer}, m_end{buffer + size} {
+    if (size < min_buffer) throw std::invalid_argument("buffer too small");
+  }
+  ChunkWriter(const ChunkWriter&) = delete;
+  ChunkWriter& operator=(const ChunkWriter&) = delete;
+  ~ChunkWriter() { flush(); }
+
+  void flush() {
+    m_out.write(m_begin, m_pos - m_begin);
+    m_pos = m_begin;
+  }
+
+  // как operator<< с настройками потока по умолчанию: символ -- сам
+  // символ, bool -- 0/1, плавающие -- %g с точностью 6
+  template <typename T>
+  void put(const T& value) {
+    if constexpr (is_narrow_char_v<T> || std::is_same_v<T, bool>) {
+      if (m_end - m_pos < 2) flush();
+      *m_pos++ = std::is_same_v<T, bool> ? char('0' + value) : char(value);
+    } else if constexpr (std::is_integral_v<T> && !is_char_v<T>) {
+      m_pos = to_chars_or_flush(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+      m_pos = to_chars_or_flush(value, std::chars_format::general, 6);
+    } else {
+      static_assert(std::is_convertible_v<const T&, std::string_view>,
+                    "flatten_to supports numbers, char and strings");
+      write(std::string_view(value));
+    }
+    *m_pos++ = ' ';
+    // to_chars ниже нужен непустой диапазон
+    if (m_pos == m_end) flush();
+  }
+
+ private:
+  template <typename T>
+  static constexpr bool is_narrow_char_v =
+      std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+      std::is_same_v<T, unsigned char>;
+
+  // широкие символы поток печатает по-своему, здесь они не поддержаны
+  template <typename T>
+  static constexpr bool is_char_v =
+      is_narrow_char_v<T> || std::is_same_v<T, wchar_t> ||
+      std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+  template <typename... Args>
+  char* to_chars_or_flush(const Args&... args) {
+    auto [ptr, ec] = std::to_chars(m_pos, m_end - 1, args...);
+    if (ec != std::errc()) {
+      flush();
+      ptr = std::to_chars(m_pos, m_end - 1, args...).ptr;
+    }
+    return ptr;
+  }
+
+  // строка может быть длиннее буфера -- тогда она идёт в поток напрямую
+  void write(std::string_view s) {
+    if (static_cast<size_t>(m_end - m_pos) <= s.size()) {
+      flush();
+      if (static_cast<size_t>(m_end - m_pos) <= s.size()) {
+        m_out.write(s.data(), s.size());
+        return;
+      }
+    }
+    m_pos = std::copy(s.begin(), s.end(), m_pos);
+  }
+};
+
+// тот же вывод, что у flatten в поток с флагами и точностью по умолчанию,
+// но без operator<< на каждый элемент
+template <typename T>
+void flatten_to(const Array<T>& array, std::ostream& out, char* buffer,
+                size_t size) {
+  ChunkWriter writer(out, buffer, size);
+  for (const auto& elem : flat_view(array)) {
+    writer.put(elem);
+  }
+}
+
+template <typename T>
+void flatten_to(const Array<T>& array, std::ostream& out) {
+  char buffer[1 << 16];
+  flatten_to(array, out, buffer, sizeof(buffer));
+}
+
+// непрерывный кусок памяти: строка Jagged или все её значения сразу
+template <typename T>
+class Span {
+ private:
+  T* m_data;
+  size_t m_size;
+
+ public:
+  Span() : m_data{nullptr}, m_size{0} {}
+  Span(T* data, size_t size) : m_data{data}, m_size{size} {}
+
+  T* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  T& operator[](size_t index) const { return m_data[index]; }
+  T* begin() const { return m_data; }
+  T* end() const { return m_data + m_size; }
+};
+
+// замена Array<Array<T>> в формате CSR: все значения в одном буфере,
+// строка i -- values[offsets[i], offsets[i + 1]). Две аллокации на весь
+// массив вместо одной на каждую строку
+template <typename T>
+class Jagged {
+  static_assert(!std::is_same_v<T, bool>,
+                "Array<bool> packs bits and has no data() for Span");
+
+ private:
+  Array<T> m_values;
+  Array<size_t> m_offsets{0};
+
+ public:
+  Jagged() = default;
+
+  explicit Jagged(const Array<Array<T>>& nested) {
+    size_t total = 0;
+    for (const auto& row : nested) total += row.size();
+    reserve(nested.size(), total);
+    for (const auto& row : nested) append_row(row.begin(), row.end());
+  }
+
+  void reserve(size_t rows, size_t values) {
+    m_offsets.reserve(rows + 1);
+    m_values.reserve(values);
+  }
+
+  // пустая строка; дополняется через push_back
+  void append_row() { m_offsets.push_back(m_values.size()); }
+
+  // только итераторы: append_row(3, 7) не должен стать insert(count, value)
+  template <typename It,
+            typename = std::enable_if_t<std::is_convertible_v<
+                typename std::iterator_traits<It>::iterator_category,
+                std::input_iterator_tag>>>
+  void append_row(It first, It last) {
+    m_values.insert(m_values.end(), first, last);
+    m_offsets.push_back(m_values.size());
+  }
+
+  void append_row(std::initializer_list<T> row) {
+    append_row(row.begin(), row.end());
+  }
+
+  // в конец последней строки
+  void push_back(const T& value) {
+    if (m_offsets.size() == 1) append_row();
+    m_values.push_back(value);
+    ++m_offsets.back();
+  }
+
+  size_t size() const { return m_offsets.size() - 1; }
+  bool empty() const { return size() == 0; }
+
+  Span<T> operator[](size_t row) {
+    return Span<T>(m_values.data() + m_offsets[row],
+                   m_offsets[row + 1] - m_offsets[row]);
+  }
+  Span<const T> operator[](size_t row) const {
+    return Span<const T>(m_values.data() + m_offsets[row],
+                         m_offsets[row + 1] - m_offsets[row]);
+  }
+
+  // все значения подряд, без копирования
+  Span<T> flat() { return Span<T>(m_values.data(), m_values.size()); }
+  Span<const T> flat() const {
+    return Span<const T>(m_values.data(), m_values.size());
+  }
+
+  const Array<size_t>& offsets() const { return m_offsets; }
+
+  class RowIterator {
+   private:
+    const Jagged* m_jagged;
+    size_t m_row;
+
+   public:
+    RowIterator(const Jagged* jagged, size_t row)
+        : m_jagged{jagged}, m_row{row} {}
+
+    Span<const T> operator*() const { return (*m_jagged)[m_row]; }
+    RowIterator& operator++() {
+      ++m_row;
+      return *this;
+    }
+    bool operator!=(const RowIterator& other) const {
+      return m_row != other.m_row;
+    }
+  };
+
+  RowIterator begin() const { return RowIterator(this, 0); }
+  RowIterator end() const { return RowIterator(this, size()); }
+};
+
+template <typename T>
+void flatten(const Jagged<T>& jagged, std::ostream& out) {
+  for (const auto& elem : jagged.flat()) {
+    out << elem << " ";
+  }
+}
+
+template <typename T>
+Span<const T> flat_view(const Jagged<T>& jagged) {
+  return jagged.flat();
+}
+
+template <typename T>
+void flatten_to(const Jagged<T>& jagged, std::ostream& out, char* buffer,
+                size_t size) {
+  ChunkWriter writer(out, buffer, size);
+  for (const auto& elem : jagged.flat()) {
+    writer.put(elem);
+  }
+}
+
+template <typename T>
+void flatten_to(const Jagged<T>& jagged, std::ostream& out) {
+  char buffer[1 << 16];
+  flatten_to(jagged, out, buffer, sizeof(buffer));
+}
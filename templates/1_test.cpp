@@ -0,0 +1,201 @@
+#include "1.cpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// 1. ScopePtr: удалители вызываются ровно один раз
+struct Tracked {
+  static int alive;
+  int value;
+  explicit Tracked(int v) : value(v) { ++alive; }
+  ~Tracked() { --alive; }
+};
+
+int Tracked::alive = 0;
+
+struct CountingPool {
+  static int allocated;
+
+  static void* allocate() {
+    ++allocated;
+    return std::malloc(sizeof(Tracked));
+  }
+  static void deallocate(void* p) {
+    --allocated;
+    std::free(p);
+  }
+};
+
+int CountingPool::allocated = 0;
+
+class Arena {
+ private:
+  int m_live = 0;
+
+ public:
+  void* allocate() {
+    ++m_live;
+    return std::malloc(sizeof(Tracked));
+  }
+  void deallocate(void* p) {
+    --m_live;
+    std::free(p);
+  }
+  int live() const { return m_live; }
+};
+
+static_assert(sizeof(ScopePtr<Tracked, PoolDelete<Tracked, CountingPool>>) ==
+              sizeof(Tracked*));
+static_assert(sizeof(ScopePtr<Tracked, ArenaDelete<Tracked, Arena>>) ==
+              2 * sizeof(Tracked*));
+// без арены ArenaDelete не создать, и ScopePtr без удалителя тоже
+static_assert(!std::is_default_constructible_v<
+              ScopePtr<Tracked, ArenaDelete<Tracked, Arena>>>);
+static_assert(!std::is_constructible_v<
+              ScopePtr<Tracked, ArenaDelete<Tracked, Arena>>, Tracked*>);
+static_assert(!std::is_default_constructible_v<
+              ScopePtr<Tracked[], ArenaDelete<Tracked, Arena>>>);
+static_assert(std::is_default_constructible_v<ScopePtr<Tracked>>);
+
+// удалитель с состоянием, созданный без аргументов, обнулён
+struct TaggedDelete {
+  int tag;
+
+  void operator()(Tracked* ptr) const {
+    assert(0 == tag);
+    delete ptr;
+  }
+};
+
+void test_deleters() {
+  {
+    ScopePtr<Tracked, TaggedDelete> tagged(new Tracked(0));
+    assert(0 == tagged.get_deleter().tag);
+  }
+  {
+    ScopePtr<Tracked, PoolDelete<Tracked, CountingPool>> a(
+        new (CountingPool::allocate()) Tracked(1));
+    ScopePtr<Tracked, PoolDelete<Tracked, CountingPool>> b(
+        new (CountingPool::allocate()) Tracked(2));
+    assert(2 == Tracked::alive && 2 == CountingPool::allocated);
+    a = std::move(b);
+    assert(2 == a->value && 1 == b->value);
+    b.reset();
+    assert(1 == Tracked::alive && 1 == CountingPool::allocated);
+  }
+  assert(0 == Tracked::alive && 0 == CountingPool::allocated);
+
+  Arena first, second;
+  {
+    using Ptr = ScopePtr<Tracked, ArenaDelete<Tracked, Arena>>;
+    Ptr a(new (first.allocate()) Tracked(1), {&first});
+    Ptr b(new (second.allocate()) Tracked(2), {&second});
+    // удалитель уезжает вместе с указателем
+    a = std::move(b);
+    assert(&second == a.get_deleter().arena && 2 == a->value);
+    Ptr c(std::move(a));
+    assert(!a && &second == c.get_deleter().arena);
+    // пустой указатель с удалителем: reset удаляет через ту же арену
+    Ptr empty(nullptr, &first);
+    empty.reset(new (first.allocate()) Tracked(4));
+    assert(2 == first.live());
+  }
+  assert(0 == Tracked::alive && 0 == first.live() && 0 == second.live());
+
+  {
+    void* raw = ::operator new(sizeof(Tracked), std::align_val_t{64});
+    ScopePtr<Tracked, AlignedDelete<Tracked, 64>> aligned(new (raw) Tracked(3));
+    ScopePtr<Tracked[]> array(new Tracked[2]{Tracked(4), Tracked(5)});
+    assert(3 == Tracked::alive && 5 == array[1].value);
+    Tracked* released = aligned.release();
+    assert(!aligned);
+    AlignedDelete<Tracked, 64>()(released);
+  }
+  assert(0 == Tracked::alive);
+}
+
+// 6. flatten_to печатает то же, что flatten, и с маленьким буфером
+template <typename Container>
+void check_flatten_to(const Container& array) {
+  std::ostringstream expected, chunked, direct;
+  flatten(array, expected);
+  char buffer[ChunkWriter::min_buffer];
+  flatten_to(array, chunked, buffer, sizeof(buffer));
+  flatten_to(array, direct);
+  assert(expected.str() == chunked.str() && expected.str() == direct.str());
+}
+
+void test_flatten_to() {
+  double const inf = std::numeric_limits<double>::infinity();
+  check_flatten_to(Array<double>{0.1, 1.0 / 3, -0.0, 1e20, 123456.5, 1e-7,
+                                 2.5e-308, -inf, 100, 1234567});
+  check_flatten_to(Array<float>{0.1f, 3.4e38f, 16777216.f});
+  check_flatten_to(Array<long double>{0.1L, 1e300L});
+  check_flatten_to(Array<Array<char>>{{'a', 'b'}, {}, {'z'}});
+  check_flatten_to(Array<signed char>{'x', -5});
+  check_flatten_to(Array<unsigned char>{'q', 200});
+  check_flatten_to(Array<bool>{true, false});
+  check_flatten_to(Array<std::string>{"one", "", std::string(100, 's')});
+  check_flatten_to(Array<Array<Array<long long>>>{
+      {{std::numeric_limits<long long>::min(), 0}, {}}, {}, {{1, 2, 3}}});
+  check_flatten_to(Jagged<double>({{0.5, 2.0 / 3}, {}, {1e100}}));
+
+  Array<int> many(1000);
+  for (int i = 0; i < 1000; ++i) many[i] = i * 7919 - 3000000;
+  check_flatten_to(many);
+}
+
+template <typename J, typename = void>
+struct can_append_counts : std::false_type {};
+
+template <typename J>
+struct can_append_counts<
+    J, std::void_t<decltype(std::declval<J&>().append_row(3, 7))>>
+    : std::true_type {};
+
+static_assert(!can_append_counts<Jagged<int>>::value);
+
+void test_jagged() {
+  Jagged<int> jagged({{1, 2}, {}, {3}});
+  assert(3 == jagged.size() && !jagged.empty());
+  assert((jagged.offsets() == Array<size_t>{0, 2, 2, 3}));
+  assert(2 == jagged[0].size() && jagged[1].empty() && 3 == jagged[2][0]);
+
+  std::istringstream in("4 5 6");
+  jagged.append_row(std::istream_iterator<int>(in),
+                    std::istream_iterator<int>());
+  std::list<int> list{7};
+  jagged.append_row(list.begin(), list.end());
+  jagged.append_row({8, 9});
+  jagged.append_row();
+  jagged.push_back(10);
+  jagged.flat()[0] = 0;
+
+  Array<Array<int>> rows;
+  for (Span<const int> row : jagged) rows.emplace_back(row.begin(), row.end());
+  assert((rows == Array<Array<int>>{
+                      {0, 2}, {}, {3}, {4, 5, 6}, {7}, {8, 9}, {10}}));
+  assert(10 == jagged.flat().size());
+
+  Jagged<std::string> words;
+  assert(words.empty());
+  words.push_back("first");
+  assert(1 == words.size() && "first" == words[0][0]);
+}
+
+}  // namespace
+
+int main() {
+  test_deleters();
+  test_flatten_to();
+  test_jagged();
+  return 0;
+}